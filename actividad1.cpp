@@ -1,282 +1,2550 @@
 #include <iostream>
 #include <vector>
 #include <queue>
-#include <set>
+#include <deque>
+#include <unordered_set>
+#include <unordered_map>
 #include <cmath>
+#include <cstdlib>
 #include <algorithm>
+#include <iomanip>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <new>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
 
 using namespace std;
 
-// estructua para representar el estado del tablero
-// (Juan hizo esta parte)
-struct Estado {
-    vector<vector<int>> tablero;
-    int x, y; // posision del espacio vacio
-    int g, h; // costo y euristica
-    string camino; // movimientos realizados
-    
-    int f() const { return g + h; }
-    
-    // operador para la cola de prioridad
-    bool operator>(const Estado& otro) const {
-        return f() > otro.f();
+// movimientos del espacio vacio (caben en 2 bits)
+enum Movimiento { ARRIBA = 0, ABAJO = 1, IZQUIERDA = 2, DERECHA = 3 };
+
+const char* nombreMovimiento(Movimiento m) {
+    static const char* nombres[] = {"ARRIBA", "ABAJO", "IZQUIERDA", "DERECHA"};
+    return nombres[m];
+}
+
+// tablero empaquetado en un entero de 64 bits:
+// bits 0-35 -> 9 fichas de 4 bits (celda i en los bits 4*i..4*i+3)
+// bits 36-39 -> posicion del espacio vacio (0..8)
+// asi un estado se copia y se compara como un entero, sin memoria dinamica
+typedef uint64_t Tablero64;
+
+const int BITS_VACIO = 36;
+
+inline int ficha(Tablero64 t, int celda) {
+    return (int)((t >> (4 * celda)) & 0xF);
+}
+
+inline int posVacio(Tablero64 t) {
+    return (int)((t >> BITS_VACIO) & 0xF);
+}
+
+// mueve la ficha que esta en 'destino' hacia el vacio y actualiza la posicion del vacio
+inline Tablero64 moverVacio(Tablero64 t, int destino) {
+    int vacio = posVacio(t);
+    Tablero64 f = (t >> (4 * destino)) & 0xF;
+    t &= ~((Tablero64)0xF << (4 * destino));
+    t |= f << (4 * vacio);
+    t &= ~((Tablero64)0xF << BITS_VACIO);
+    t |= (Tablero64)destino << BITS_VACIO;
+    return t;
+}
+
+Tablero64 empaquetar(const vector<vector<int>>& tablero) {
+    Tablero64 t = 0;
+    for(int i = 0; i < 3; i++) {
+        for(int j = 0; j < 3; j++) {
+            int celda = i * 3 + j;
+            t |= (Tablero64)tablero[i][j] << (4 * celda);
+            if(tablero[i][j] == 0) t |= (Tablero64)celda << BITS_VACIO;
+        }
+    }
+    return t;
+}
+
+// TABLEROS DE ANCHO W
+// el ancho es un parametro de plantilla, asi los lazos sobre las celdas tienen
+// limites constantes y el compilador los desenrolla. la codificacion depende de W:
+// - 3x3: el Tablero64 de arriba (fichas + vacio en un entero)
+// - 4x4: 16 fichas de 4 bits llenan los 64 bits, el vacio se encuentra buscando
+//   el nibble en cero con un truco de bits (sin recorrer el tablero)
+// - 5x5 o mas: 5 bits por ficha repartidos en varias palabras + el vacio aparte
+
+template <int W>
+struct Codificacion {
+    static const int N = W * W;
+    static const int POR_PALABRA = 12; // fichas de 5 bits por palabra de 64
+    static const int PALABRAS = (N + POR_PALABRA - 1) / POR_PALABRA;
+
+    struct Tablero {
+        uint64_t palabra[PALABRAS];
+        uint8_t vacio;
+
+        bool operator==(const Tablero& otro) const {
+            for(int i = 0; i < PALABRAS; i++) {
+                if(palabra[i] != otro.palabra[i]) return false;
+            }
+            return vacio == otro.vacio;
+        }
+        bool operator!=(const Tablero& otro) const { return !(*this == otro); }
+    };
+
+    struct Hash {
+        size_t operator()(const Tablero& t) const {
+            uint64_t h = 0xcbf29ce484222325ULL;
+            for(int i = 0; i < PALABRAS; i++) {
+                h = (h ^ t.palabra[i]) * 0x100000001b3ULL;
+                h ^= h >> 29;
+            }
+            return (size_t)h;
+        }
+    };
+
+    static int ficha(const Tablero& t, int celda) {
+        return (int)((t.palabra[celda / POR_PALABRA] >> (5 * (celda % POR_PALABRA))) & 31);
+    }
+
+    static int posVacio(const Tablero& t) { return t.vacio; }
+
+    static void poner(Tablero& t, int celda, int valor) {
+        uint64_t& p = t.palabra[celda / POR_PALABRA];
+        int desp = 5 * (celda % POR_PALABRA);
+        p = (p & ~((uint64_t)31 << desp)) | ((uint64_t)valor << desp);
+    }
+
+    static Tablero moverVacio(Tablero t, int destino) {
+        poner(t, t.vacio, ficha(t, destino));
+        poner(t, destino, 0);
+        t.vacio = (uint8_t)destino;
+        return t;
+    }
+
+    static Tablero desdeMatriz(const vector<vector<int>>& m) {
+        Tablero t;
+        memset(&t, 0, sizeof(t));
+        for(int celda = 0; celda < N; celda++) {
+            int valor = m[celda / W][celda % W];
+            poner(t, celda, valor);
+            if(valor == 0) t.vacio = (uint8_t)celda;
+        }
+        return t;
+    }
+};
+
+template <>
+struct Codificacion<3> {
+    static const int N = 9;
+    typedef Tablero64 Tablero;
+    typedef hash<uint64_t> Hash;
+
+    static int ficha(Tablero t, int celda) { return ::ficha(t, celda); }
+    static int posVacio(Tablero t) { return ::posVacio(t); }
+    static Tablero moverVacio(Tablero t, int destino) { return ::moverVacio(t, destino); }
+    static Tablero desdeMatriz(const vector<vector<int>>& m) { return empaquetar(m); }
+};
+
+template <>
+struct Codificacion<4> {
+    static const int N = 16;
+    typedef uint64_t Tablero;
+    typedef hash<uint64_t> Hash;
+
+    static int ficha(Tablero t, int celda) { return (int)((t >> (4 * celda)) & 0xF); }
+
+    // el unico nibble en cero es el vacio: (x - 0x11..) & ~x & 0x88.. marca el primero
+    static int posVacio(Tablero t) {
+        uint64_t ceros = (t - 0x1111111111111111ULL) & ~t & 0x8888888888888888ULL;
+        return __builtin_ctzll(ceros) >> 2;
+    }
+
+    static Tablero moverVacio(Tablero t, int destino) {
+        int vacio = posVacio(t);
+        uint64_t f = (t >> (4 * destino)) & 0xF;
+        t &= ~((uint64_t)0xF << (4 * destino));
+        t |= f << (4 * vacio);
+        return t;
+    }
+
+    static Tablero desdeMatriz(const vector<vector<int>>& m) {
+        uint64_t t = 0;
+        for(int celda = 0; celda < N; celda++) {
+            t |= (uint64_t)m[celda / 4][celda % 4] << (4 * celda);
+        }
+        return t;
+    }
+};
+
+// tabla de movimientos constexpr: destino del vacio para cada celda y movimiento
+// (-1 si se sale del tablero). se genera en compilacion para cada ancho, asi la
+// generacion de vecinos es una lectura de tabla sin revisar limites a mano
+template <int W>
+constexpr int destinoMovimiento(int celda, int m) {
+    return m == ARRIBA ? (celda >= W ? celda - W : -1) :
+           m == ABAJO ? (celda < W * (W - 1) ? celda + W : -1) :
+           m == IZQUIERDA ? (celda % W != 0 ? celda - 1 : -1) :
+           (celda % W != W - 1 ? celda + 1 : -1);
+}
+
+template <int... I> struct Indices {};
+template <int K, int... I> struct GenerarIndices : GenerarIndices<K - 1, K - 1, I...> {};
+template <int... I> struct GenerarIndices<0, I...> { typedef Indices<I...> Tipo; };
+
+template <int W, class Secuencia = typename GenerarIndices<W * W * 4>::Tipo>
+struct TablaMovidas;
+
+template <int W, int... I>
+struct TablaMovidas<W, Indices<I...>> {
+    static constexpr int8_t destino[sizeof...(I)] = { (int8_t)destinoMovimiento<W>(I / 4, I % 4)... };
+};
+
+template <int W, int... I>
+constexpr int8_t TablaMovidas<W, Indices<I...>>::destino[sizeof...(I)];
+
+// destino del vacio en el 3x3 al aplicar un movimiento (-1 si se sale del tablero)
+inline int destinoVacio(int vacio, int m) {
+    return TablaMovidas<3>::destino[vacio * 4 + m];
+}
+
+// nodo del arbol de busqueda, guardado en un vector (pool) y referenciado por indice
+// en vez de copiar el camino completo, cada nodo solo recuerda a su padre y el
+// movimiento que lo genero: padreMov = (indice del padre << 2) | movimiento
+// (Juan hizo esta parte)
+const uint32_t SIN_PADRE = 0xFFFFFFFFu >> 2;
+
+template <class Tablero>
+struct Nodo {
+    Tablero tablero; // fichas (+ posicion del vacio)
+    uint32_t padreMov;
+
+    uint32_t padre() const { return padreMov >> 2; }
+    Movimiento movimiento() const { return (Movimiento)(padreMov & 3); }
+};
+
+// por que termino una busqueda
+enum FinBusqueda { FIN_SOLUCION, FIN_SIN_SOLUCION, FIN_MEMORIA, FIN_TIEMPO };
+
+// contadores de una busqueda, para saber en que se fue el tiempo
+struct EstadisticasBusqueda {
+    long long generados;  // hijos creados (incluye los que despues se descartan)
+    long long obsoletos;  // nodos sacados de la abierta que ya estaban cerrados o mejorados
+    size_t picoAbierta;   // maximo de la lista abierta (IDA*: profundidad maxima)
+    size_t picoCerrada;   // maximo del conjunto de visitados
+    size_t picoBytes;     // memoria estimada de las estructuras de la busqueda
+    long long asignaciones; // pedidos al heap de las estructuras de esta busqueda
+    long long pedidosArena; // pedidos atendidos por la arena (sin esta, irian uno a uno al heap)
+    double segundos;
+
+    EstadisticasBusqueda() : generados(0), obsoletos(0), picoAbierta(0), picoCerrada(0), picoBytes(0), asignaciones(0),
+                             pedidosArena(0), segundos(0) {}
+};
+
+// resultado de una busqueda: lista de movimientos del vacio desde el inicial
+struct ResultadoBusqueda {
+    bool encontrada;
+    FinBusqueda fin;
+    vector<Movimiento> movimientos;
+    long long nodosExpandidos;
+    long long expandidosAdelante, expandidosAtras; // solo la busqueda bidireccional
+    EstadisticasBusqueda estadisticas;
+
+    ResultadoBusqueda() : encontrada(false), fin(FIN_SIN_SOLUCION), nodosExpandidos(0), expandidosAdelante(0), expandidosAtras(0) {}
+};
+
+// presupuesto de una busqueda: memoria estimada y tiempo de reloj (0 = sin limite)
+// reemplaza al viejo tope de 200,000 iteraciones, que cortaba tableros profundos
+// que si tenian solucion
+struct LimitesBusqueda {
+    size_t bytesMaximos;
+    double segundosMaximos;
+    chrono::steady_clock::time_point inicio;
+
+    LimitesBusqueda() : bytesMaximos((size_t)1 << 30), segundosMaximos(0) {}
+
+    void empezar() { inicio = chrono::steady_clock::now(); }
+
+    double transcurrido() const {
+        return chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    }
+
+    // FIN_SOLUCION si todavia queda presupuesto, si no el motivo del corte
+    FinBusqueda revisar(size_t bytes) const {
+        if(bytesMaximos > 0 && bytes > bytesMaximos) return FIN_MEMORIA;
+        if(segundosMaximos > 0 && transcurrido() > segundosMaximos) return FIN_TIEMPO;
+        return FIN_SOLUCION;
+    }
+};
+
+// cada cuantas expansiones se revisa el presupuesto (pedir la hora cuesta)
+const long long REVISAR_PRESUPUESTO = 4096;
+
+// memoria aproximada de un unordered_set/map: un nodo por elemento (valor + siguiente
+// + hash guardado) y un puntero por cubeta
+template <class Conjunto>
+size_t bytesConjunto(const Conjunto& c) {
+    return c.size() * (sizeof(typename Conjunto::value_type) + 2 * sizeof(void*)) + c.bucket_count() * sizeof(void*);
+}
+
+// ARENA DE MEMORIA
+// los conjuntos de visitados piden un nodo al heap por cada estado insertado y los
+// vectores de nodos crecen de a copias. la arena reserva bloques grandes y entrega
+// memoria avanzando un puntero; liberar de a uno no hace nada y al terminar la busqueda
+// se reinicia toda junta (los bloques quedan reservados para la busqueda siguiente).
+// los pedidos grandes (arreglos de cubetas, vectores de nodos) van aparte y, al
+// liberarse, quedan guardados para reusarlos en vez de volver al heap. cada busqueda (y
+// cada hilo) tiene la suya, asi no hay competencia por el lock del heap entre hilos, y
+// cuenta sus propios pedidos (no hace falta un contador global).
+class Arena {
+private:
+    static const size_t TAM_BLOQUE = (size_t)1 << 20;
+
+    struct Grande {
+        char* p;
+        size_t tam;
+    };
+
+    vector<char*> bloques;
+    vector<Grande> grandes; // pedidos de mas de un cuarto de bloque en uso
+    vector<Grande> libres;  // pedidos grandes ya liberados, para reusar
+    size_t bloqueActual;
+    size_t usado;
+    long long pedidos;      // pedidos atendidos
+    long long reservas;     // veces que se pidio memoria al heap
+
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+    char* reservar(size_t n) {
+        char* p = (char*)malloc(n);
+        if(p == NULL) throw bad_alloc();
+        reservas++;
+        return p;
+    }
+
+    void* pedirGrande(size_t n) {
+        // el libre mas chico que alcance
+        size_t mejor = libres.size();
+        for(size_t i = 0; i < libres.size(); i++) {
+            if(libres[i].tam >= n && (mejor == libres.size() || libres[i].tam < libres[mejor].tam)) mejor = i;
+        }
+        Grande g;
+        if(mejor < libres.size()) {
+            g = libres[mejor];
+            libres[mejor] = libres.back();
+            libres.pop_back();
+        } else {
+            g.p = reservar(n);
+            g.tam = n;
+        }
+        grandes.push_back(g);
+        return g.p;
+    }
+
+public:
+    Arena() : bloqueActual(0), usado(0), pedidos(0), reservas(0) {}
+
+    ~Arena() {
+        for(size_t i = 0; i < bloques.size(); i++) free(bloques[i]);
+        for(size_t i = 0; i < grandes.size(); i++) free(grandes[i].p);
+        for(size_t i = 0; i < libres.size(); i++) free(libres[i].p);
+    }
+
+    void* pedir(size_t n, size_t alineacion) {
+        pedidos++;
+        if(n > TAM_BLOQUE / 4) return pedirGrande(n);
+        usado = (usado + alineacion - 1) & ~(alineacion - 1);
+        if(bloques.empty() || usado + n > TAM_BLOQUE) {
+            if(!bloques.empty()) bloqueActual++;
+            if(bloqueActual == bloques.size()) bloques.push_back(reservar(TAM_BLOQUE));
+            usado = 0;
+        }
+        void* p = bloques[bloqueActual] + usado;
+        usado += n;
+        return p;
+    }
+
+    // solo los pedidos grandes se recuperan antes de reiniciar
+    void devolver(void* p, size_t n) {
+        if(n <= TAM_BLOQUE / 4) return;
+        for(size_t i = 0; i < grandes.size(); i++) {
+            if(grandes[i].p == p) {
+                libres.push_back(grandes[i]);
+                grandes[i] = grandes.back();
+                grandes.pop_back();
+                return;
+            }
+        }
+    }
+
+    // todo lo entregado queda invalido; los bloques se conservan
+    void reiniciar() {
+        libres.insert(libres.end(), grandes.begin(), grandes.end());
+        grandes.clear();
+        bloqueActual = 0;
+        usado = 0;
+    }
+
+    long long pedidosAtendidos() const { return pedidos; }
+    long long reservasHeap() const { return reservas; }
+};
+
+// asignador de la STL que pide a una arena (contenedores de hash y vectores de nodos)
+template <class T>
+struct AsignadorArena {
+    typedef T value_type;
+    Arena* arena;
+
+    explicit AsignadorArena(Arena* a) : arena(a) {}
+    template <class U> AsignadorArena(const AsignadorArena<U>& otro) : arena(otro.arena) {}
+
+    T* allocate(size_t n) { return (T*)arena->pedir(n * sizeof(T), alignof(T)); }
+    void deallocate(T* p, size_t n) { arena->devolver(p, n * sizeof(T)); }
+
+    template <class U> bool operator==(const AsignadorArena<U>& otro) const { return arena == otro.arena; }
+    template <class U> bool operator!=(const AsignadorArena<U>& otro) const { return arena != otro.arena; }
+};
+
+// conjunto de visitados y mapa estado -> nodo de un tablero de ancho W, sobre una arena
+template <int W>
+using ConjuntoArena = unordered_set<typename Codificacion<W>::Tablero, typename Codificacion<W>::Hash,
+                                    equal_to<typename Codificacion<W>::Tablero>,
+                                    AsignadorArena<typename Codificacion<W>::Tablero>>;
+
+template <int W>
+using MapaArena = unordered_map<typename Codificacion<W>::Tablero, uint32_t, typename Codificacion<W>::Hash,
+                                equal_to<typename Codificacion<W>::Tablero>,
+                                AsignadorArena<pair<const typename Codificacion<W>::Tablero, uint32_t>>>;
+
+template <class T>
+using VectorArena = vector<T, AsignadorArena<T>>;
+
+// vacia un contenedor que pide a una arena, antes de reiniciarla. se cambia por uno
+// nuevo porque clear() conserva el arreglo de cubetas (o la capacidad), que vive en la arena
+template <class Contenedor>
+void vaciarEnArena(Contenedor& c) {
+    Contenedor vacio(c.get_allocator());
+    c.swap(vacio);
+}
+
+// para los vectores de nodos: despues de reiniciar la arena se vuelve a reservar la
+// capacidad que tenian, asi no crecen de a copias en cada busqueda (los pedidos
+// grandes salen de los que la arena guardo, sin ir al heap)
+template <class T>
+void reservarComoAntes(VectorArena<T>& v, size_t capacidad) {
+    v.reserve(capacidad);
+}
+
+// reconstruir la secuencia de movimientos siguiendo los padres desde la meta
+template <class Nodos>
+void reconstruirCamino(const Nodos& nodos, uint32_t meta, vector<Movimiento>& movimientos) {
+    movimientos.clear();
+    for(uint32_t i = meta; nodos[i].padre() != SIN_PADRE; i = nodos[i].padre()) {
+        movimientos.push_back(nodos[i].movimiento());
+    }
+    reverse(movimientos.begin(), movimientos.end());
+}
+
+// heuristica: distancia manhattan (+ conflicto lineal opcional)
+// el objetivo se compila una sola vez en tablas, asi evaluar una ficha es
+// leer dist[ficha][celda] en vez de buscarla en el tablero objetivo
+// Maria hizo la version original de esta funcion
+template <int W>
+struct TablaHeuristica {
+    static const int ANCHO = W;
+    static const int N = W * W;
+    typedef Codificacion<W> C;
+    typedef typename C::Tablero Tablero;
+
+    int dist[N][N];              // dist[ficha][celda] = distancia manhattan a su meta
+    int filaMeta[N], colMeta[N]; // posicion objetivo de cada ficha
+    bool conflictoLineal;
+
+    void compilar(const Tablero& objetivo, bool usarConflicto) {
+        conflictoLineal = usarConflicto;
+        for(int k = 0; k < N; k++) {
+            int valor = C::ficha(objetivo, k);
+            filaMeta[valor] = k / W;
+            colMeta[valor] = k % W;
+        }
+        for(int valor = 0; valor < N; valor++) {
+            for(int celda = 0; celda < N; celda++) {
+                dist[valor][celda] = (valor == 0) ? 0 :
+                    abs(celda / W - filaMeta[valor]) + abs(celda % W - colMeta[valor]);
+            }
+        }
+    }
+
+    // penalizacion de conflicto lineal en una linea: las fichas que pertenecen a esta
+    // linea pero estan en orden invertido tienen que salir de ella (2 movimientos extra
+    // cada una). la menor cantidad a sacar es fichas - subsecuencia creciente mas larga
+    int conflictoLinea(const Tablero& t, int linea, bool esFila) const {
+        int metas[W];
+        int n = 0;
+        for(int k = 0; k < W; k++) {
+            int celda = esFila ? linea * W + k : k * W + linea;
+            int valor = C::ficha(t, celda);
+            if(valor == 0) continue;
+            if(esFila && filaMeta[valor] == linea) metas[n++] = colMeta[valor];
+            if(!esFila && colMeta[valor] == linea) metas[n++] = filaMeta[valor];
+        }
+        if(n < 2) return 0;
+        int largo[W];
+        int mejor = 0;
+        for(int i = 0; i < n; i++) {
+            largo[i] = 1;
+            for(int j = 0; j < i; j++) {
+                if(metas[j] < metas[i] && largo[j] + 1 > largo[i]) largo[i] = largo[j] + 1;
+            }
+            if(largo[i] > mejor) mejor = largo[i];
+        }
+        return 2 * (n - mejor);
+    }
+
+    // evaluacion completa (solo se usa para el estado inicial)
+    int evaluar(const Tablero& t) const {
+        int h = 0;
+        for(int celda = 0; celda < N; celda++) {
+            h += dist[C::ficha(t, celda)][celda];
+        }
+        if(conflictoLineal) {
+            for(int linea = 0; linea < W; linea++) {
+                h += conflictoLinea(t, linea, true) + conflictoLinea(t, linea, false);
+            }
+        }
+        return h;
+    }
+
+    // cambio de h al mover el vacio de 'padre' a 'destino' (hijo ya calculado)
+    // solo la ficha movida cambia de celda, asi que manhattan es una resta de tablas;
+    // el conflicto lineal solo cambia en las dos lineas que cruza la ficha
+    int delta(const Tablero& padre, const Tablero& hijo, int destino) const {
+        int vacio = C::posVacio(padre);
+        int valor = C::ficha(padre, destino);
+        int d = dist[valor][vacio] - dist[valor][destino];
+        if(conflictoLineal) {
+            bool vertical = (vacio % W) == (destino % W);
+            // movimiento vertical -> la ficha cambia de fila; horizontal -> de columna
+            int l1 = vertical ? vacio / W : vacio % W;
+            int l2 = vertical ? destino / W : destino % W;
+            d += conflictoLinea(hijo, l1, vertical) + conflictoLinea(hijo, l2, vertical)
+               - conflictoLinea(padre, l1, vertical) - conflictoLinea(padre, l2, vertical);
+        }
+        return d;
+    }
+};
+
+// BASES DE DATOS DE PATRONES ADITIVAS (4x4)
+// manhattan no alcanza para el 15-puzzle. las 15 fichas se parten en 3 grupos
+// disjuntos de 5 (en el orden en que aparecen en la meta) y para cada grupo se
+// guarda cuantos movimientos de SUS fichas hacen falta para llevarlas a la meta,
+// sin importar las demas. como los grupos no comparten fichas, las distancias se
+// pueden sumar y la heuristica sigue siendo admisible.
+//
+// indice de un patron: las celdas de sus 5 fichas, 4 bits cada una (16^5 entradas).
+// se llena con un BFS 0-1 hacia atras desde la meta: mover el vacio sobre una celda
+// libre cuesta 0 y sobre una ficha del grupo cuesta 1.
+class BaseDatosPatrones {
+public:
+    typedef Codificacion<4> C;
+    typedef C::Tablero Tablero;
+    static const int TAM_GRUPO = 5;
+
+private:
+    int grupoDe[16];      // grupo de cada ficha (-1 para el vacio)
+    int lugarEnGrupo[16]; // orden de la ficha dentro de su grupo
+    vector<vector<uint8_t>> tablas;
+    Tablero meta;
+
+    void construirGrupo(const vector<int>& fichas, vector<uint8_t>& tabla) {
+        int k = (int)fichas.size();
+        int bitsPatron = 4 * k;
+        uint32_t tamPatron = 1u << bitsPatron;
+
+        // estado del BFS = patron | (vacio << bitsPatron)
+        vector<uint8_t> dist((size_t)tamPatron * 16, 0xFF);
+        uint32_t inicio = (uint32_t)C::posVacio(meta) << bitsPatron;
+        for(int celda = 0; celda < 16; celda++) {
+            int valor = C::ficha(meta, celda);
+            if(valor != 0 && grupoDe[valor] == grupoDe[fichas[0]]) {
+                inicio |= (uint32_t)celda << (4 * lugarEnGrupo[valor]);
+            }
+        }
+
+        deque<uint32_t> cola;
+        dist[inicio] = 0;
+        cola.push_back(inicio);
+        while(!cola.empty()) {
+            uint32_t estado = cola.front();
+            cola.pop_front();
+            int d = dist[estado];
+            int vacio = (int)(estado >> bitsPatron);
+            uint32_t patron = estado & (tamPatron - 1);
+
+            int ocupante[16];
+            for(int c = 0; c < 16; c++) ocupante[c] = -1;
+            for(int j = 0; j < k; j++) ocupante[(patron >> (4 * j)) & 0xF] = j;
+
+            for(int m = 0; m < 4; m++) {
+                int destino = TablaMovidas<4>::destino[vacio * 4 + m];
+                if(destino < 0) continue;
+                int j = ocupante[destino];
+                uint32_t nuevo = patron;
+                int costo = 0;
+                if(j >= 0) {
+                    nuevo = (patron & ~(0xFu << (4 * j))) | ((uint32_t)vacio << (4 * j));
+                    costo = 1;
+                }
+                uint32_t siguiente = nuevo | ((uint32_t)destino << bitsPatron);
+                if(d + costo < dist[siguiente]) {
+                    dist[siguiente] = (uint8_t)(d + costo);
+                    if(costo == 0) cola.push_front(siguiente);
+                    else cola.push_back(siguiente);
+                }
+            }
+        }
+
+        // la tabla final guarda el minimo sobre todas las posiciones del vacio
+        tabla.assign(tamPatron, 0xFF);
+        for(uint32_t p = 0; p < tamPatron; p++) {
+            for(uint32_t v = 0; v < 16; v++) {
+                uint8_t d = dist[p | (v << bitsPatron)];
+                if(d < tabla[p]) tabla[p] = d;
+            }
+        }
+    }
+
+    uint32_t indiceGrupo(Tablero t, int g) const {
+        uint32_t idx = 0;
+        for(int celda = 0; celda < 16; celda++) {
+            int valor = C::ficha(t, celda);
+            if(valor != 0 && grupoDe[valor] == g) idx |= (uint32_t)celda << (4 * lugarEnGrupo[valor]);
+        }
+        return idx;
+    }
+
+public:
+    BaseDatosPatrones() : meta(0) {}
+
+    bool construida(Tablero objetivo) const { return !tablas.empty() && meta == objetivo; }
+
+    void construir(Tablero objetivo) {
+        meta = objetivo;
+        vector<vector<int>> grupos;
+        grupoDe[0] = -1;
+        lugarEnGrupo[0] = -1;
+        for(int celda = 0; celda < 16; celda++) {
+            int valor = C::ficha(objetivo, celda);
+            if(valor == 0) continue;
+            if(grupos.empty() || (int)grupos.back().size() == TAM_GRUPO) grupos.push_back(vector<int>());
+            grupoDe[valor] = (int)grupos.size() - 1;
+            lugarEnGrupo[valor] = (int)grupos.back().size();
+            grupos.back().push_back(valor);
+        }
+        tablas.assign(grupos.size(), vector<uint8_t>());
+        for(size_t g = 0; g < grupos.size(); g++) construirGrupo(grupos[g], tablas[g]);
+    }
+
+    int evaluar(Tablero t) const {
+        uint32_t idx[16] = {0};
+        for(int celda = 0; celda < 16; celda++) {
+            int valor = C::ficha(t, celda);
+            if(valor != 0) idx[grupoDe[valor]] |= (uint32_t)celda << (4 * lugarEnGrupo[valor]);
+        }
+        int h = 0;
+        for(size_t g = 0; g < tablas.size(); g++) h += tablas[g][idx[g]];
+        return h;
+    }
+
+    // solo cambia el grupo de la ficha movida: su celda pasa de 'destino' al vacio
+    int delta(Tablero padre, Tablero hijo, int destino) const {
+        (void)hijo;
+        int vacio = C::posVacio(padre);
+        int valor = C::ficha(padre, destino);
+        int g = grupoDe[valor];
+        int desp = 4 * lugarEnGrupo[valor];
+        uint32_t antes = indiceGrupo(padre, g);
+        uint32_t despues = (antes & ~(0xFu << desp)) | ((uint32_t)vacio << desp);
+        return (int)tablas[g][despues] - (int)tablas[g][antes];
+    }
+};
+
+// heuristica liviana que apunta a una base de patrones compartida (se copia por hilo)
+struct HeuristicaPatrones {
+    static const int ANCHO = 4;
+    typedef Codificacion<4>::Tablero Tablero;
+
+    const BaseDatosPatrones* base;
+
+    explicit HeuristicaPatrones(const BaseDatosPatrones* b) : base(b) {}
+    int evaluar(Tablero t) const { return base->evaluar(t); }
+    int delta(Tablero padre, Tablero hijo, int destino) const { return base->delta(padre, hijo, destino); }
+};
+
+// LISTAS ABIERTAS
+// las dos tienen la misma interfaz (insertar / sacar / vacia / limpiar) para que
+// cualquier motor de busqueda pueda usar una u otra como parametro de plantilla
+
+// lista abierta por cubetas: f = g + h es un entero chico, asi que hay una cubeta
+// por cada f y dentro de ella una pila (LIFO) por cada g. se saca siempre la f
+// minima y, a igual f, el g mas alto (el nodo mas profundo). insertar y sacar son O(1)
+// las pilas no estan en la arena (se conservan con su capacidad entre busquedas), asi
+// que la lista cuenta sola las veces que crece y le pide memoria al heap
+template <typename T>
+class ListaAbiertaCubetas {
+private:
+    vector<vector<vector<T>>> cubetas; // cubetas[f][g]
+    vector<int> gMaximo;               // g mas alto posiblemente ocupado en cada f
+    int fMinimo;
+    size_t cantidad;
+    long long reservas;
+
+public:
+    ListaAbiertaCubetas() : fMinimo(0), cantidad(0), reservas(0) {}
+
+    void insertar(int f, int g, const T& dato) {
+        if(f >= (int)cubetas.size()) {
+            if((size_t)f + 1 > cubetas.capacity()) reservas++;
+            if((size_t)f + 1 > gMaximo.capacity()) reservas++;
+            cubetas.resize(f + 1);
+            gMaximo.resize(f + 1, -1);
+        }
+        if(g >= (int)cubetas[f].size()) {
+            if((size_t)g + 1 > cubetas[f].capacity()) reservas++;
+            cubetas[f].resize(g + 1);
+        }
+        vector<T>& pila = cubetas[f][g];
+        if(pila.size() == pila.capacity()) reservas++;
+        pila.push_back(dato);
+        if(g > gMaximo[f]) gMaximo[f] = g;
+        if(cantidad == 0 || f < fMinimo) fMinimo = f;
+        cantidad++;
+    }
+
+    // saca el elemento de menor f (y mayor g); no llamar con la lista vacia
+    T sacar(int& f, int& g) {
+        while(gMaximo[fMinimo] < 0) fMinimo++;
+        vector<vector<T>>& porG = cubetas[fMinimo];
+        while(porG[gMaximo[fMinimo]].empty()) gMaximo[fMinimo]--;
+        f = fMinimo;
+        g = gMaximo[fMinimo];
+        T dato = porG[g].back();
+        porG[g].pop_back();
+        if(porG[g].empty()) {
+            // bajar al siguiente g ocupado (o -1 si la cubeta quedo vacia)
+            int k = g;
+            while(k >= 0 && porG[k].empty()) k--;
+            gMaximo[fMinimo] = k;
+        }
+        cantidad--;
+        return dato;
+    }
+
+    int fMin() const { return fMinimo; }
+    bool vacia() const { return cantidad == 0; }
+    size_t tamano() const { return cantidad; }
+    long long reservasHeap() const { return reservas; }
+
+    // vacia la lista pero conserva la memoria de las cubetas para reusarla
+    void limpiar() {
+        for(size_t f = 0; f < cubetas.size(); f++) {
+            for(size_t g = 0; g < cubetas[f].size(); g++) cubetas[f][g].clear();
+            gMaximo[f] = -1;
+        }
+        fMinimo = 0;
+        cantidad = 0;
+    }
+};
+
+// lista abierta con el heap binario de la STL (la version original, ordena solo por f)
+// se deja para comparar en el benchmark
+template <typename T>
+class ListaAbiertaHeap {
+private:
+    struct Entrada {
+        int f, g;
+        T dato;
+
+        // operador para la cola de prioridad
+        bool operator>(const Entrada& otro) const {
+            return f > otro.f;
+        }
+    };
+    // lo mismo que priority_queue, pero con el vector a la vista para contar cuando crece
+    vector<Entrada> pq;
+    long long reservas;
+
+public:
+    ListaAbiertaHeap() : reservas(0) {}
+
+    void insertar(int f, int g, const T& dato) {
+        Entrada e;
+        e.f = f;
+        e.g = g;
+        e.dato = dato;
+        if(pq.size() == pq.capacity()) reservas++;
+        pq.push_back(e);
+        push_heap(pq.begin(), pq.end(), greater<Entrada>());
+    }
+
+    T sacar(int& f, int& g) {
+        pop_heap(pq.begin(), pq.end(), greater<Entrada>());
+        Entrada e = pq.back();
+        pq.pop_back();
+        f = e.f;
+        g = e.g;
+        return e.dato;
+    }
+
+    int fMin() const { return pq.front().f; }
+    bool vacia() const { return pq.empty(); }
+    size_t tamano() const { return pq.size(); }
+    long long reservasHeap() const { return reservas; }
+    void limpiar() { vector<Entrada>().swap(pq); }
+};
+
+// imprimir tablero
+// Pedro hizo esto
+void imprimirTablero(const vector<vector<int>>& tablero) {
+    int ancho = (int)tablero.size();
+    int digitos = (ancho * ancho > 10) ? 2 : 1;
+    string separador(ancho * (digitos + 3) + 1, '-');
+    cout << separador << endl;
+    for(int i = 0; i < ancho; i++) {
+        cout << "| ";
+        for(int j = 0; j < ancho; j++) {
+            if(tablero[i][j] == 0)
+                cout << string(digitos, ' ') << " | ";
+            else
+                cout << setw(digitos) << tablero[i][j] << " | ";
+        }
+        cout << endl << separador << endl;
+    }
+}
+
+// contar inversiones para verificar solucionabilidad
+// Pedro agrego esta validacion
+int contarInversiones(const vector<vector<int>>& tablero) {
+    vector<int> arr;
+    for(size_t i = 0; i < tablero.size(); i++) {
+        for(size_t j = 0; j < tablero[i].size(); j++) {
+            if(tablero[i][j] != 0) {
+                arr.push_back(tablero[i][j]);
+            }
+        }
+    }
+
+    int inversiones = 0;
+    for(size_t i = 0; i < arr.size(); i++) {
+        for(size_t j = i + 1; j < arr.size(); j++) {
+            if(arr[i] > arr[j]) inversiones++;
+        }
+    }
+
+    return inversiones;
+}
+
+int filaDelVacio(const vector<vector<int>>& tablero) {
+    for(size_t i = 0; i < tablero.size(); i++) {
+        for(size_t j = 0; j < tablero[i].size(); j++) {
+            if(tablero[i][j] == 0) return (int)i;
+        }
+    }
+    return 0;
+}
+
+bool puedenConectarse(const vector<vector<int>>& inicial, const vector<vector<int>>& objetivo) {
+    int inv1 = contarInversiones(inicial);
+    int inv2 = contarInversiones(objetivo);
+    // con ancho par, cada movimiento vertical cambia la paridad de las inversiones
+    // y tambien la fila del vacio, asi que lo que se conserva es la suma de las dos
+    if(inicial.size() % 2 == 0) {
+        inv1 += filaDelVacio(inicial);
+        inv2 += filaDelVacio(objetivo);
+    }
+    // ambas deben tener la misma paridad (ambas pares o ambas impares)
+    return (inv1 % 2) == (inv2 % 2);
+}
+
+// funcion para resolver el puzzle usando A*
+// todos trabajamos en esta parte
+// la lista abierta es un parametro de plantilla (cubetas por defecto, heap para comparar)
+
+// estructuras de una busqueda A*; se pueden reusar entre busquedas (modo lote)
+// para no volver a pedir memoria en cada tablero
+template <int W, class ListaAbierta>
+struct ContextoAEstrella {
+    typedef Codificacion<W> C;
+    typedef typename C::Tablero Tablero;
+
+    Arena arena;
+    ListaAbierta abierta;
+    ConjuntoArena<W> visitados;
+    VectorArena<Nodo<Tablero>> nodos;
+
+    ContextoAEstrella()
+        : visitados(0, typename C::Hash(), equal_to<Tablero>(), AsignadorArena<Tablero>(&arena)),
+          nodos(AsignadorArena<Nodo<Tablero>>(&arena)) {}
+
+    // la arena no se comparte: una copia (un Solucionador por hilo) arranca vacia
+    ContextoAEstrella(const ContextoAEstrella&)
+        : visitados(0, typename C::Hash(), equal_to<Tablero>(), AsignadorArena<Tablero>(&arena)),
+          nodos(AsignadorArena<Nodo<Tablero>>(&arena)) {}
+
+    void limpiar() {
+        size_t capacidad = nodos.capacity();
+        abierta.limpiar();
+        vaciarEnArena(visitados);
+        vaciarEnArena(nodos);
+        arena.reiniciar();
+        reservarComoAntes(nodos, capacidad);
+    }
+
+    long long reservasHeap() const { return arena.reservasHeap() + abierta.reservasHeap(); }
+};
+
+template <class ListaAbierta, class Heuristica>
+ResultadoBusqueda buscarAEstrella(typename Heuristica::Tablero inicio, typename Heuristica::Tablero meta, const Heuristica& heuristica,
+                                  ContextoAEstrella<Heuristica::ANCHO, ListaAbierta>& contexto, const LimitesBusqueda& limites) {
+    const int W = Heuristica::ANCHO;
+    typedef Codificacion<W> C;
+    typedef typename C::Tablero Tablero;
+
+    contexto.limpiar();
+    ListaAbierta& abierta = contexto.abierta;
+    ConjuntoArena<W>& visitados = contexto.visitados;
+    VectorArena<Nodo<Tablero>>& nodos = contexto.nodos;
+    ResultadoBusqueda resultado;
+    EstadisticasBusqueda& est = resultado.estadisticas;
+    long long reservasAntes = contexto.reservasHeap();
+    long long pedidosAntes = contexto.arena.pedidosAtendidos();
+
+    Nodo<Tablero> raiz;
+    raiz.tablero = inicio;
+    raiz.padreMov = SIN_PADRE << 2;
+    nodos.push_back(raiz);
+
+    abierta.insertar(heuristica.evaluar(inicio), 0, 0u);
+
+    while(!abierta.vacia()) {
+        if(abierta.tamano() > est.picoAbierta) est.picoAbierta = abierta.tamano();
+        int f, g;
+        uint32_t actual = abierta.sacar(f, g);
+        Tablero tablero = nodos[actual].tablero;
+
+        // verificar si llegamos al objetivo
+        if(tablero == meta) {
+            resultado.encontrada = true;
+            resultado.fin = FIN_SOLUCION;
+            reconstruirCamino(nodos, actual, resultado.movimientos);
+            break;
+        }
+
+        // si ya visitamos este estado, continuar
+        if(!visitados.insert(tablero).second) {
+            est.obsoletos++;
+            continue;
+        }
+        resultado.nodosExpandidos++;
+
+        if(resultado.nodosExpandidos % REVISAR_PRESUPUESTO == 0) {
+            size_t bytes = nodos.capacity() * sizeof(Nodo<Tablero>) + bytesConjunto(visitados)
+                         + abierta.tamano() * sizeof(uint32_t);
+            est.picoBytes = max(est.picoBytes, bytes);
+            FinBusqueda corte = limites.revisar(bytes);
+            if(corte != FIN_SOLUCION) {
+                resultado.fin = corte;
+                break;
+            }
+        }
+
+        // generar estados vecinos (arriba, abajo, izquierda, derecha)
+        int vacio = C::posVacio(tablero);
+        for(int i = 0; i < 4; i++) {
+            int destino = TablaMovidas<W>::destino[vacio * 4 + i];
+            if(destino < 0) continue;
+
+            Tablero vecino = C::moverVacio(tablero, destino);
+            if(visitados.count(vecino) > 0) continue;
+
+            Nodo<Tablero> hijo;
+            hijo.tablero = vecino;
+            hijo.padreMov = (actual << 2) | (uint32_t)i;
+
+            int fHijo = f + 1 + heuristica.delta(tablero, vecino, destino);
+            abierta.insertar(fHijo, g + 1, (uint32_t)nodos.size());
+            nodos.push_back(hijo);
+            est.generados++;
+        }
+    }
+
+    est.picoCerrada = visitados.size();
+    est.picoBytes = max(est.picoBytes, nodos.capacity() * sizeof(Nodo<Tablero>) + bytesConjunto(visitados));
+    est.asignaciones = contexto.reservasHeap() - reservasAntes;
+    est.pedidosArena = contexto.arena.pedidosAtendidos() - pedidosAntes;
+    return resultado; // si no se encontro, fin dice si fue por presupuesto o porque no hay camino
+}
+
+template <class ListaAbierta, class Heuristica>
+ResultadoBusqueda buscarAEstrella(typename Heuristica::Tablero inicio, typename Heuristica::Tablero meta, const Heuristica& heuristica) {
+    ContextoAEstrella<Heuristica::ANCHO, ListaAbierta> contexto;
+    LimitesBusqueda limites;
+    limites.empezar();
+    return buscarAEstrella(inicio, meta, heuristica, contexto, limites);
+}
+
+// IDA*: profundizacion iterativa sobre f = g + h
+// un solo tablero que se mueve y se deshace en el lugar, memoria O(profundidad)
+// y sin reservar memoria por nodo. nunca se aplica el movimiento inverso al anterior
+template <class Heuristica>
+class BusquedaIDA {
+private:
+    static const int W = Heuristica::ANCHO;
+    typedef Codificacion<W> C;
+    typedef typename C::Tablero Tablero;
+
+    const Heuristica& heuristica;
+    Tablero meta;
+    vector<Movimiento> camino;
+    long long expandidos;
+    EstadisticasBusqueda* est;
+    const LimitesBusqueda* limites;
+    FinBusqueda corte;
+
+    static const int ENCONTRADO = -1;
+    static const int CORTADO = -2; // se acabo el tiempo
+
+    // devuelve ENCONTRADO, CORTADO o el menor f que supero el limite en esta rama
+    int buscar(const Tablero& tablero, int g, int h, int limite, int anterior) {
+        int f = g + h;
+        if(f > limite) return f;
+        if(tablero == meta) return ENCONTRADO;
+        expandidos++;
+        if((size_t)g > est->picoAbierta) est->picoAbierta = g;
+        if(expandidos % REVISAR_PRESUPUESTO == 0) {
+            corte = limites->revisar(camino.capacity() * sizeof(Movimiento));
+            if(corte != FIN_SOLUCION) return CORTADO;
+        }
+
+        int minimo = 1 << 30;
+        int vacio = C::posVacio(tablero);
+        for(int m = 0; m < 4; m++) {
+            if(anterior >= 0 && m == (anterior ^ 1)) continue; // deshace el anterior
+            int destino = TablaMovidas<W>::destino[vacio * 4 + m];
+            if(destino < 0) continue;
+
+            Tablero hijo = C::moverVacio(tablero, destino);
+            camino.push_back((Movimiento)m);
+            est->generados++;
+            int t = buscar(hijo, g + 1, h + heuristica.delta(tablero, hijo, destino), limite, m);
+            if(t < 0) return t;
+            camino.pop_back();
+            if(t < minimo) minimo = t;
+        }
+        return minimo;
+    }
+
+public:
+    BusquedaIDA(const Heuristica& h, const Tablero& objetivo)
+        : heuristica(h), meta(objetivo), expandidos(0), est(NULL), limites(NULL), corte(FIN_SOLUCION) {}
+
+    // IDA* casi no usa memoria, del presupuesto solo cuenta el tiempo
+    ResultadoBusqueda resolver(const Tablero& inicio, const LimitesBusqueda& lim) {
+        ResultadoBusqueda resultado;
+        int h = heuristica.evaluar(inicio);
+        int limite = h;
+        camino.clear();
+        expandidos = 0;
+        est = &resultado.estadisticas;
+        limites = &lim;
+
+        while(true) {
+            int t = buscar(inicio, 0, h, limite, -1);
+            if(t == ENCONTRADO) {
+                resultado.encontrada = true;
+                resultado.fin = FIN_SOLUCION;
+                resultado.movimientos = camino;
+                break;
+            }
+            if(t == CORTADO) {
+                resultado.fin = corte;
+                break;
+            }
+            if(t >= (1 << 30)) break; // no quedan estados por explorar
+            limite = t;
+        }
+        resultado.nodosExpandidos = expandidos;
+        resultado.estadisticas.picoBytes = camino.capacity() * sizeof(Movimiento);
+        return resultado;
+    }
+};
+
+// BUSQUEDA BIDIRECCIONAL (MM)
+// una busqueda hacia adelante desde el inicial y otra hacia atras desde la meta
+// (la de atras usa una heuristica compilada con el inicial como objetivo). cada lado
+// ordena su lista por pr = max(f, 2g), asi ninguno de los dos pasa de la mitad del
+// camino, y siempre se expande el lado con menor pr. U es el mejor camino encontrado
+// al cruzarse las dos fronteras; cuando U <= min(pr) de las dos listas ya no puede
+// haber uno mas corto y se unen las dos mitades.
+template <class Heuristica>
+class BusquedaBidireccional {
+private:
+    static const int W = Heuristica::ANCHO;
+    typedef Codificacion<W> C;
+    typedef typename C::Tablero Tablero;
+
+    struct Lado {
+        Arena arena;
+        ListaAbiertaCubetas<uint32_t> abierta;
+        MapaArena<W> mejor; // estado -> nodo con menor g
+        VectorArena<Nodo<Tablero>> nodos;
+        VectorArena<int> g;
+        VectorArena<int> h;
+        VectorArena<char> cerrado;
+        long long expandidos, obsoletos;
+        size_t picoAbierta;
+
+        Lado() : mejor(0, typename C::Hash(), equal_to<Tablero>(), typename MapaArena<W>::allocator_type(&arena)),
+                 nodos(AsignadorArena<Nodo<Tablero>>(&arena)), g(AsignadorArena<int>(&arena)),
+                 h(AsignadorArena<int>(&arena)), cerrado(AsignadorArena<char>(&arena)),
+                 expandidos(0), obsoletos(0), picoAbierta(0) {}
+        Lado(const Lado&) : mejor(0, typename C::Hash(), equal_to<Tablero>(), typename MapaArena<W>::allocator_type(&arena)),
+                            nodos(AsignadorArena<Nodo<Tablero>>(&arena)), g(AsignadorArena<int>(&arena)),
+                            h(AsignadorArena<int>(&arena)), cerrado(AsignadorArena<char>(&arena)),
+                            expandidos(0), obsoletos(0), picoAbierta(0) {}
+
+        void limpiar() {
+            size_t capacidad = nodos.capacity();
+            abierta.limpiar();
+            vaciarEnArena(mejor);
+            vaciarEnArena(nodos);
+            vaciarEnArena(g);
+            vaciarEnArena(h);
+            vaciarEnArena(cerrado);
+            arena.reiniciar();
+            reservarComoAntes(nodos, capacidad);
+            reservarComoAntes(g, capacidad);
+            reservarComoAntes(h, capacidad);
+            reservarComoAntes(cerrado, capacidad);
+            expandidos = 0;
+            obsoletos = 0;
+            picoAbierta = 0;
+        }
+
+        size_t bytes() const {
+            return nodos.capacity() * (sizeof(Nodo<Tablero>) + 2 * sizeof(int) + 1) + bytesConjunto(mejor)
+                 + abierta.tamano() * sizeof(uint32_t);
+        }
+
+        long long reservasHeap() const { return arena.reservasHeap() + abierta.reservasHeap(); }
+
+        uint32_t agregar(const Tablero& t, uint32_t padreMov, int gNodo, int hNodo) {
+            Nodo<Tablero> nodo;
+            nodo.tablero = t;
+            nodo.padreMov = padreMov;
+            uint32_t idx = (uint32_t)nodos.size();
+            nodos.push_back(nodo);
+            g.push_back(gNodo);
+            h.push_back(hNodo);
+            cerrado.push_back(0);
+            mejor[t] = idx;
+            abierta.insertar(max(gNodo + hNodo, 2 * gNodo), gNodo, idx);
+            if(abierta.tamano() > picoAbierta) picoAbierta = abierta.tamano();
+            return idx;
+        }
+    };
+
+    Lado adelante, atras;
+    int mejorCosto;              // U
+    uint32_t cruceAdelante, cruceAtras;
+
+    // busca el estado recien generado en el otro lado y actualiza U si mejora
+    void revisarCruce(const Lado& otro, const Tablero& t, int gNodo, uint32_t idx, bool esAdelante) {
+        typename MapaArena<W>::const_iterator it = otro.mejor.find(t);
+        if(it == otro.mejor.end()) return;
+        int costo = gNodo + otro.g[it->second];
+        if(costo < mejorCosto) {
+            mejorCosto = costo;
+            cruceAdelante = esAdelante ? idx : it->second;
+            cruceAtras = esAdelante ? it->second : idx;
+        }
+    }
+
+    // saca el siguiente nodo vigente del lado (descarta los reemplazados y cerrados)
+    bool sacarVigente(Lado& lado, uint32_t& idx) {
+        while(!lado.abierta.vacia()) {
+            int pr, g;
+            idx = lado.abierta.sacar(pr, g);
+            if(!lado.cerrado[idx] && lado.mejor[lado.nodos[idx].tablero] == idx) return true;
+            lado.obsoletos++;
+        }
+        return false;
+    }
+
+    template <class H>
+    void expandir(Lado& lado, const Lado& otro, uint32_t idx, const H& heuristica, bool esAdelante) {
+        lado.cerrado[idx] = 1;
+        lado.expandidos++;
+        Tablero tablero = lado.nodos[idx].tablero;
+        int gHijo = lado.g[idx] + 1;
+        int vacio = C::posVacio(tablero);
+        for(int m = 0; m < 4; m++) {
+            int destino = TablaMovidas<W>::destino[vacio * 4 + m];
+            if(destino < 0) continue;
+            Tablero vecino = C::moverVacio(tablero, destino);
+            typename MapaArena<W>::iterator it = lado.mejor.find(vecino);
+            if(it != lado.mejor.end() && lado.g[it->second] <= gHijo) continue;
+
+            int hHijo = lado.h[idx] + heuristica.delta(tablero, vecino, destino);
+            uint32_t hijo = lado.agregar(vecino, (idx << 2) | (uint32_t)m, gHijo, hHijo);
+            revisarCruce(otro, vecino, gHijo, hijo, esAdelante);
+        }
+    }
+
+public:
+    BusquedaBidireccional() : mejorCosto(0), cruceAdelante(0), cruceAtras(0) {}
+
+    // hAtras debe estar compilada con 'inicio' como objetivo
+    ResultadoBusqueda resolver(const Tablero& inicio, const Tablero& meta, const Heuristica& hAdelante,
+                               const TablaHeuristica<W>& hAtras, const LimitesBusqueda& limites) {
+        ResultadoBusqueda resultado;
+        EstadisticasBusqueda& est = resultado.estadisticas;
+        adelante.limpiar();
+        atras.limpiar();
+        long long reservasAntes = adelante.reservasHeap() + atras.reservasHeap();
+        long long pedidosAntes = adelante.arena.pedidosAtendidos() + atras.arena.pedidosAtendidos();
+        mejorCosto = 1 << 30;
+
+        adelante.agregar(inicio, SIN_PADRE << 2, 0, hAdelante.evaluar(inicio));
+        uint32_t raizAtras = atras.agregar(meta, SIN_PADRE << 2, 0, hAtras.evaluar(meta));
+        revisarCruce(adelante, meta, 0, raizAtras, false);
+
+        long long iteraciones = 0;
+        bool demostrado = false;
+
+        while(true) {
+            if(adelante.abierta.vacia() || atras.abierta.vacia()) {
+                demostrado = true; // un lado agoto todos sus estados
+                break;
+            }
+            // fMin() es una cota inferior del pr minimo de cada lista
+            int cota = min(adelante.abierta.fMin(), atras.abierta.fMin());
+            if(mejorCosto <= cota) {
+                demostrado = true;
+                break;
+            }
+            if(++iteraciones % REVISAR_PRESUPUESTO == 0) {
+                size_t bytes = adelante.bytes() + atras.bytes();
+                est.picoBytes = max(est.picoBytes, bytes);
+                FinBusqueda corte = limites.revisar(bytes);
+                if(corte != FIN_SOLUCION) {
+                    resultado.fin = corte;
+                    break;
+                }
+            }
+
+            uint32_t idx;
+            if(adelante.abierta.fMin() <= atras.abierta.fMin()) {
+                if(sacarVigente(adelante, idx)) expandir(adelante, atras, idx, hAdelante, true);
+            } else {
+                if(sacarVigente(atras, idx)) expandir(atras, adelante, idx, hAtras, false);
+            }
+        }
+
+        resultado.expandidosAdelante = adelante.expandidos;
+        resultado.expandidosAtras = atras.expandidos;
+        resultado.nodosExpandidos = adelante.expandidos + atras.expandidos;
+        est.generados = (long long)(adelante.nodos.size() + atras.nodos.size()) - 2;
+        est.obsoletos = adelante.obsoletos + atras.obsoletos;
+        est.picoAbierta = adelante.picoAbierta + atras.picoAbierta;
+        est.picoCerrada = adelante.mejor.size() + atras.mejor.size();
+        est.picoBytes = max(est.picoBytes, adelante.bytes() + atras.bytes());
+        est.asignaciones = adelante.reservasHeap() + atras.reservasHeap() - reservasAntes;
+        est.pedidosArena = adelante.arena.pedidosAtendidos() + atras.arena.pedidosAtendidos() - pedidosAntes;
+        if(!demostrado || mejorCosto == (1 << 30)) return resultado;
+
+        // mitad de adelante tal cual + mitad de atras invertida (cada movimiento al reves)
+        vector<Movimiento> mitadAtras;
+        reconstruirCamino(adelante.nodos, cruceAdelante, resultado.movimientos);
+        reconstruirCamino(atras.nodos, cruceAtras, mitadAtras);
+        for(size_t i = mitadAtras.size(); i-- > 0; ) {
+            resultado.movimientos.push_back((Movimiento)(mitadAtras[i] ^ 1));
+        }
+        resultado.encontrada = true;
+        resultado.fin = FIN_SOLUCION;
+        return resultado;
+    }
+};
+
+// A* PARALELO DISTRIBUIDO POR HASH (HDA*)
+// cada estado tiene un hilo dueño (hash del tablero modulo la cantidad de hilos) y
+// solo ese hilo lo guarda en su lista abierta y en su tabla de visitados, asi no hay
+// estructuras compartidas. los hijos que pertenecen a otro hilo se juntan en lotes y
+// se dejan en la bandeja del dueño, una pila sin locks (push con compare_exchange,
+// el dueño se lleva todo de una vez con exchange).
+//
+// como cada hilo sigue su propio orden de f, encontrar la meta no alcanza: U es la
+// mejor longitud vista y se descartan los nodos con f >= U. se termina cuando todos
+// los hilos estan ociosos y no hay lotes en vuelo; ahi no queda ningun nodo que
+// pueda mejorar U y la solucion es optima.
+template <class Heuristica>
+class BusquedaHDA {
+private:
+    static const int W = Heuristica::ANCHO;
+    typedef Codificacion<W> C;
+    typedef typename C::Tablero Tablero;
+
+    static const uint64_t RAIZ = ~(uint64_t)0;
+
+    // nodo guardado por su dueño; el padre es (hilo << 32) | indice y puede ser de otro hilo
+    struct Entrada {
+        Tablero tablero;
+        uint64_t padre;
+        int g, h;
+        int movimiento;
+    };
+
+    struct Lote {
+        Lote* siguiente;
+        vector<Entrada> entradas;
+    };
+
+    struct Hilo {
+        atomic<Lote*> bandeja;
+        char relleno[64]; // la bandeja de cada hilo en su propia linea de cache
+        Arena arena;      // cada hilo pide a su propia arena, sin competir por el heap
+        VectorArena<Entrada> nodos;
+        MapaArena<W> mejor;
+        ListaAbiertaCubetas<uint32_t> abierta;
+        vector<vector<Entrada>> salida; // hijos pendientes de enviar, por destino
+        long long expandidos, generados, obsoletos;
+        long long reservasLotes; // lotes y crecimiento de 'salida' (van al heap: cruzan de hilo)
+        size_t picoAbierta;
+
+        Hilo() : bandeja(NULL), nodos(AsignadorArena<Entrada>(&arena)),
+                 mejor(0, typename C::Hash(), equal_to<Tablero>(), typename MapaArena<W>::allocator_type(&arena)),
+                 expandidos(0), generados(0), obsoletos(0), reservasLotes(0), picoAbierta(0) {}
+
+        void limpiar() {
+            size_t capacidad = nodos.capacity();
+            vaciarEnArena(nodos);
+            vaciarEnArena(mejor);
+            arena.reiniciar();
+            reservarComoAntes(nodos, capacidad);
+            abierta.limpiar();
+            expandidos = generados = obsoletos = 0;
+            picoAbierta = 0;
+        }
+
+        size_t bytes() const {
+            return nodos.capacity() * sizeof(Entrada) + bytesConjunto(mejor) + abierta.tamano() * sizeof(uint32_t);
+        }
+
+        long long reservasHeap() const { return arena.reservasHeap() + abierta.reservasHeap() + reservasLotes; }
+    };
+
+    const Heuristica* heuristica; // se fija en cada resolver
+    Tablero meta;
+    int numHilos;
+    vector<Hilo> hilos;
+
+    atomic<int> mejorCosto;       // U
+    atomic<long long> enVuelo;    // entradas enviadas que el dueño todavia no dio por recibidas
+    atomic<int> ociosos;
+    atomic<bool> terminado;
+    atomic<int> corte;            // FIN_SOLUCION mientras quede presupuesto
+    uint64_t nodoMeta;
+    mutex cerrojoMeta;
+
+    int duenio(const Tablero& t) const {
+        uint64_t x = (uint64_t)typename C::Hash()(t) * 0x9E3779B97F4A7C15ULL;
+        return (int)((x >> 32) % (uint64_t)numHilos);
+    }
+
+    // el dueño agrega la entrada si mejora el g que ya tenia para ese estado
+    void recibir(Hilo& yo, const Entrada& e) {
+        typename MapaArena<W>::iterator it = yo.mejor.find(e.tablero);
+        if(it != yo.mejor.end() && yo.nodos[it->second].g <= e.g) return;
+        uint32_t idx = (uint32_t)yo.nodos.size();
+        yo.nodos.push_back(e);
+        if(it != yo.mejor.end()) it->second = idx;
+        else yo.mejor[e.tablero] = idx;
+        yo.abierta.insertar(e.g + e.h, e.g, idx);
+        if(yo.abierta.tamano() > yo.picoAbierta) yo.picoAbierta = yo.abierta.tamano();
+    }
+
+    void enviar(Hilo& yo) {
+        for(int d = 0; d < numHilos; d++) {
+            if(yo.salida[d].empty()) continue;
+            Lote* lote = new Lote;
+            yo.reservasLotes++;
+            lote->entradas.swap(yo.salida[d]);
+            enVuelo.fetch_add((long long)lote->entradas.size());
+            Lote* cabeza = hilos[d].bandeja.load(memory_order_relaxed);
+            do {
+                lote->siguiente = cabeza;
+            } while(!hilos[d].bandeja.compare_exchange_weak(cabeza, lote, memory_order_release, memory_order_relaxed));
+        }
+    }
+
+    void trabajar(int h, const LimitesBusqueda* limites) {
+        Hilo& yo = hilos[h];
+        long long recibidos = 0;
+        long long desdeRevision = 0;
+        const int PORCION = 64; // expansiones entre revisiones de la bandeja
+
+        while(!terminado.load()) {
+            Lote* lote = yo.bandeja.exchange(NULL, memory_order_acquire);
+            while(lote != NULL) {
+                for(size_t k = 0; k < lote->entradas.size(); k++) recibir(yo, lote->entradas[k]);
+                recibidos += lote->entradas.size();
+                Lote* siguiente = lote->siguiente;
+                delete lote;
+                lote = siguiente;
+            }
+
+            int trabajo = 0;
+            while(trabajo < PORCION && !yo.abierta.vacia()) {
+                int f, g;
+                uint32_t idx = yo.abierta.sacar(f, g);
+                Entrada nodo = yo.nodos[idx];
+                if(yo.mejor[nodo.tablero] != idx) { // ya hay un camino mejor
+                    yo.obsoletos++;
+                    continue;
+                }
+                int cota = mejorCosto.load(memory_order_relaxed);
+                if(f >= cota) continue;
+                trabajo++;
+
+                if(nodo.tablero == meta) {
+                    lock_guard<mutex> guardia(cerrojoMeta);
+                    if(g < mejorCosto.load()) {
+                        mejorCosto.store(g);
+                        nodoMeta = ((uint64_t)h << 32) | idx;
+                    }
+                    continue;
+                }
+
+                yo.expandidos++;
+                int vacio = C::posVacio(nodo.tablero);
+                for(int m = 0; m < 4; m++) {
+                    if(nodo.padre != RAIZ && m == (nodo.movimiento ^ 1)) continue;
+                    int destino = TablaMovidas<W>::destino[vacio * 4 + m];
+                    if(destino < 0) continue;
+
+                    Entrada hijo;
+                    hijo.tablero = C::moverVacio(nodo.tablero, destino);
+                    hijo.padre = ((uint64_t)h << 32) | idx;
+                    hijo.g = g + 1;
+                    hijo.h = nodo.h + heuristica->delta(nodo.tablero, hijo.tablero, destino);
+                    hijo.movimiento = m;
+                    if(hijo.g + hijo.h >= cota) continue;
+
+                    yo.generados++;
+                    int d = duenio(hijo.tablero);
+                    if(d == h) recibir(yo, hijo);
+                    else {
+                        if(yo.salida[d].size() == yo.salida[d].capacity()) yo.reservasLotes++;
+                        yo.salida[d].push_back(hijo);
+                    }
+                }
+            }
+            enviar(yo);
+
+            if(trabajo > 0) {
+                desdeRevision += trabajo;
+                if(desdeRevision >= REVISAR_PRESUPUESTO) {
+                    desdeRevision = 0;
+                    // el hash reparte los estados parejo: se estima el total con el propio
+                    FinBusqueda motivo = limites->revisar(yo.bytes() * numHilos);
+                    if(motivo != FIN_SOLUCION) {
+                        corte.store(motivo);
+                        terminado.store(true);
+                    }
+                }
+                continue;
+            }
+            if(!yo.abierta.vacia()) continue;
+
+            // ocioso: recien ahora se descuentan las entradas recibidas, asi enVuelo
+            // no llega a cero mientras quede trabajo derivado de ellas
+            enVuelo.fetch_sub(recibidos);
+            recibidos = 0;
+            ociosos.fetch_add(1);
+            while(!terminado.load()) {
+                if(yo.bandeja.load() != NULL) {
+                    ociosos.fetch_sub(1);
+                    break;
+                }
+                if(ociosos.load() == numHilos && enVuelo.load() == 0) {
+                    terminado.store(true);
+                    break;
+                }
+                this_thread::yield();
+            }
+        }
+    }
+
+public:
+    explicit BusquedaHDA(const Tablero& objetivo) : heuristica(NULL), meta(objetivo), numHilos(1) {}
+
+    // cada Solucionador tiene sus propios hilos y arenas: la copia arranca sin hilos
+    BusquedaHDA(const BusquedaHDA& otra) : heuristica(NULL), meta(otra.meta), numHilos(1) {}
+
+    ResultadoBusqueda resolver(const Tablero& inicio, const Heuristica& h, int cantidadHilos, const LimitesBusqueda& limites) {
+        ResultadoBusqueda resultado;
+        heuristica = &h;
+        EstadisticasBusqueda& est = resultado.estadisticas;
+        numHilos = cantidadHilos > 0 ? cantidadHilos : (int)thread::hardware_concurrency();
+        if(numHilos <= 0) numHilos = 1;
+
+        // los hilos (con sus arenas) se conservan entre tableros si no cambia la cantidad
+        if((int)hilos.size() != numHilos) {
+            vector<Hilo> nuevos(numHilos);
+            hilos.swap(nuevos);
+        }
+        long long reservasAntes = 0, pedidosAntes = 0;
+        for(int h = 0; h < numHilos; h++) {
+            hilos[h].limpiar();
+            hilos[h].salida.resize(numHilos);
+            reservasAntes += hilos[h].reservasHeap();
+            pedidosAntes += hilos[h].arena.pedidosAtendidos();
+        }
+        mejorCosto.store(1 << 30);
+        enVuelo.store(0);
+        ociosos.store(0);
+        terminado.store(false);
+        corte.store(FIN_SOLUCION);
+        nodoMeta = RAIZ;
+
+        Entrada raiz;
+        raiz.tablero = inicio;
+        raiz.padre = RAIZ;
+        raiz.g = 0;
+        raiz.h = heuristica->evaluar(inicio);
+        raiz.movimiento = 0;
+        recibir(hilos[duenio(inicio)], raiz);
+
+        vector<thread> trabajadores;
+        for(int h = 0; h < numHilos; h++) {
+            trabajadores.push_back(thread(&BusquedaHDA::trabajar, this, h, &limites));
+        }
+        for(size_t h = 0; h < trabajadores.size(); h++) trabajadores[h].join();
+
+        for(int h = 0; h < numHilos; h++) {
+            resultado.nodosExpandidos += hilos[h].expandidos;
+            est.generados += hilos[h].generados;
+            est.obsoletos += hilos[h].obsoletos;
+            est.picoAbierta += hilos[h].picoAbierta;
+            est.picoCerrada += hilos[h].mejor.size();
+            est.picoBytes += hilos[h].bytes();
+            est.asignaciones += hilos[h].reservasHeap();
+            est.pedidosArena += hilos[h].arena.pedidosAtendidos();
+            // lotes que quedaron sin leer si se corto por el limite
+            Lote* lote = hilos[h].bandeja.exchange(NULL);
+            while(lote != NULL) {
+                Lote* siguiente = lote->siguiente;
+                delete lote;
+                lote = siguiente;
+            }
+        }
+        est.asignaciones -= reservasAntes;
+        est.pedidosArena -= pedidosAntes;
+        if(corte.load() != FIN_SOLUCION) {
+            resultado.fin = (FinBusqueda)corte.load();
+            return resultado;
+        }
+        if(nodoMeta == RAIZ) return resultado;
+
+        for(uint64_t id = nodoMeta; ; ) {
+            const Entrada& nodo = hilos[id >> 32].nodos[id & 0xFFFFFFFFu];
+            if(nodo.padre == RAIZ) break;
+            resultado.movimientos.push_back((Movimiento)nodo.movimiento);
+            id = nodo.padre;
+        }
+        reverse(resultado.movimientos.begin(), resultado.movimientos.end());
+        resultado.encontrada = true;
+        resultado.fin = FIN_SOLUCION;
+        return resultado;
     }
 };
 
-// funcion para calcular la distancia manhattan (heuristica)
-// Maria hizo esta funcion
-int calcularHeuristica(const vector<vector<int>>& tablero, const vector<vector<int>>& objetivo) {
-    int dist = 0;
-    for(int i = 0; i < 3; i++) {
-        for(int j = 0; j < 3; j++) {
-            if(tablero[i][j] != 0) {
-                // buscar posicion objetivo
-                for(int x = 0; x < 3; x++) {
-                    for(int y = 0; y < 3; y++) {
-                        if(tablero[i][j] == objetivo[x][y]) {
-                            dist += abs(i - x) + abs(j - y);
-                        }
-                    }
-                }
-            }
+// TABLA DE DISTANCIAS PRECALCULADA
+// el 8-puzzle solo tiene 9!/2 = 181,440 estados alcanzables desde la meta, asi que
+// se puede hacer un BFS hacia atras una sola vez y guardar la distancia exacta de
+// cada estado (un byte por estado) en un archivo. despues cualquier consulta es un
+// descenso goloso: desde el estado, ir al vecino con distancia uno menor.
+//
+// indice perfecto: posicion del vacio * 8!/2 + rango de Lehmer de las 8 fichas / 2.
+// la paridad de la permutacion de fichas no cambia al mover (ancho impar), asi que el
+// ultimo digito de Lehmer que no es fijo queda determinado y se puede descartar.
+
+const int ESTADOS_POR_VACIO = 20160; // 8! / 2
+const int TOTAL_ESTADOS = 9 * ESTADOS_POR_VACIO;
+const uint8_t SIN_DISTANCIA = 0xFF;
+
+inline uint32_t indicePerfecto(Tablero64 t) {
+    static const int factorial[] = {1, 1, 2, 6, 24, 120, 720, 5040};
+    int vacio = posVacio(t);
+    int fichas[8];
+    int n = 0;
+    for(int celda = 0; celda < 9; celda++) {
+        if(celda != vacio) fichas[n++] = ficha(t, celda);
+    }
+    uint32_t rango = 0;
+    for(int i = 0; i < 8; i++) {
+        int menores = 0;
+        for(int j = i + 1; j < 8; j++) {
+            if(fichas[j] < fichas[i]) menores++;
         }
+        rango += menores * factorial[7 - i];
     }
-    return dist;
+    return vacio * ESTADOS_POR_VACIO + (rango >> 1);
 }
 
-// funcion para convertir el estado a string (para el set)
-string estadoAString(const vector<vector<int>>& tablero) {
-    string s = "";
-    for(int i = 0; i < 3; i++) {
-        for(int j = 0; j < 3; j++) {
-            s += to_string(tablero[i][j]);
+// paridad de las inversiones de las 8 fichas (sin el vacio). en el 3x3 un tablero se
+// alcanza desde la meta solo si las dos tienen la misma
+inline int paridadFichas(Tablero64 t) {
+    int vacio = posVacio(t);
+    int fichas[8];
+    int n = 0;
+    for(int celda = 0; celda < 9; celda++) {
+        if(celda != vacio) fichas[n++] = ficha(t, celda);
+    }
+    int inversiones = 0;
+    for(int i = 0; i < 8; i++) {
+        for(int j = i + 1; j < 8; j++) {
+            if(fichas[j] < fichas[i]) inversiones++;
         }
     }
-    return s;
+    return inversiones & 1;
 }
 
-// imprimir tablero
-// Pedro hizo esto
-void imprimirTablero(const vector<vector<int>>& tablero) {
-    cout << "-------------" << endl;
-    for(int i = 0; i < 3; i++) {
-        cout << "| ";
-        for(int j = 0; j < 3; j++) {
-            if(tablero[i][j] == 0)
-                cout << "  | ";
-            else
-                cout << tablero[i][j] << " | ";
+class TablaDistancias {
+private:
+    struct Encabezado {
+        char magico[4];   // "P8DT"
+        uint32_t version;
+        uint64_t meta;    // el objetivo con el que se genero la tabla
+    };
+
+    const uint8_t* datos;
+    vector<uint8_t> copia; // se usa si no hay mmap (Windows)
+    void* mapa;
+    size_t tamMapa;
+    Tablero64 meta;
+
+    void liberar() {
+#ifndef _WIN32
+        if(mapa) munmap(mapa, tamMapa);
+#endif
+        mapa = NULL;
+        datos = NULL;
+        copia.clear();
+    }
+
+public:
+    TablaDistancias() : datos(NULL), mapa(NULL), tamMapa(0), meta(0) {}
+    ~TablaDistancias() { liberar(); }
+
+    bool cargada() const { return datos != NULL; }
+
+    // BFS hacia atras desde la meta; escribe la tabla en 'ruta'
+    static bool generar(const string& ruta, Tablero64 objetivo) {
+        vector<uint8_t> dist(TOTAL_ESTADOS, SIN_DISTANCIA);
+        vector<Tablero64> cola;
+        cola.reserve(TOTAL_ESTADOS);
+        cola.push_back(objetivo);
+        dist[indicePerfecto(objetivo)] = 0;
+
+        for(size_t k = 0; k < cola.size(); k++) {
+            Tablero64 t = cola[k];
+            uint8_t d = dist[indicePerfecto(t)];
+            int vacio = posVacio(t);
+            for(int m = 0; m < 4; m++) {
+                int destino = destinoVacio(vacio, m);
+                if(destino < 0) continue;
+                Tablero64 vecino = moverVacio(t, destino);
+                uint32_t idx = indicePerfecto(vecino);
+                if(dist[idx] == SIN_DISTANCIA) {
+                    dist[idx] = d + 1;
+                    cola.push_back(vecino);
+                }
+            }
         }
-        cout << endl << "-------------" << endl;
+
+        ofstream archivo(ruta.c_str(), ios::binary);
+        if(!archivo) return false;
+        Encabezado enc;
+        memcpy(enc.magico, "P8DT", 4);
+        enc.version = 1;
+        enc.meta = objetivo;
+        archivo.write((const char*)&enc, sizeof(enc));
+        archivo.write((const char*)&dist[0], dist.size());
+        return (bool)archivo;
     }
-}
 
-// contar inversiones para verificar solucionabilidad
-// Pedro agrego esta validacion
-int contarInversiones(const vector<vector<int>>& tablero) {
-    vector<int> arr;
-    for(int i = 0; i < 3; i++) {
-        for(int j = 0; j < 3; j++) {
-            if(tablero[i][j] != 0) {
-                arr.push_back(tablero[i][j]);
+    // mapea el archivo en memoria; falla si no existe o si es de otra meta
+    bool cargar(const string& ruta, Tablero64 objetivo) {
+        liberar();
+        size_t esperado = sizeof(Encabezado) + TOTAL_ESTADOS;
+#ifndef _WIN32
+        int fd = open(ruta.c_str(), O_RDONLY);
+        if(fd < 0) return false;
+        struct stat info;
+        if(fstat(fd, &info) != 0 || (size_t)info.st_size != esperado) {
+            close(fd);
+            return false;
+        }
+        void* p = mmap(NULL, esperado, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if(p == MAP_FAILED) return false;
+        mapa = p;
+        tamMapa = esperado;
+        const uint8_t* base = (const uint8_t*)p;
+#else
+        ifstream archivo(ruta.c_str(), ios::binary);
+        if(!archivo) return false;
+        copia.resize(esperado);
+        archivo.read((char*)&copia[0], esperado);
+        if(archivo.gcount() != (streamsize)esperado) {
+            copia.clear();
+            return false;
+        }
+        const uint8_t* base = &copia[0];
+#endif
+        Encabezado enc;
+        memcpy(&enc, base, sizeof(enc));
+        if(memcmp(enc.magico, "P8DT", 4) != 0 || enc.version != 1 || enc.meta != objetivo) {
+            liberar();
+            return false;
+        }
+        datos = base + sizeof(Encabezado);
+        meta = objetivo;
+        return true;
+    }
+
+    // carga la tabla y, si no existe o no corresponde a la meta, la genera primero
+    bool cargarOGenerar(const string& ruta, Tablero64 objetivo) {
+        if(cargar(ruta, objetivo)) return true;
+        if(!generar(ruta, objetivo)) return false;
+        return cargar(ruta, objetivo);
+    }
+
+    // solo vale para tableros con la paridad de la meta: el indice descarta el bit de
+    // paridad, asi que uno de la otra paridad cae en el indice de uno resoluble
+    int distancia(Tablero64 t) const {
+        return datos[indicePerfecto(t)];
+    }
+
+    // descenso goloso: en cada paso hay algun vecino con distancia d - 1
+    ResultadoBusqueda resolver(Tablero64 inicio) const {
+        ResultadoBusqueda resultado;
+        if(paridadFichas(inicio) != paridadFichas(meta)) return resultado; // no se alcanza desde la meta
+        int d = distancia(inicio);
+        if(d == SIN_DISTANCIA) return resultado;
+
+        Tablero64 t = inicio;
+        while(d > 0) {
+            int vacio = posVacio(t);
+            for(int m = 0; m < 4; m++) {
+                int destino = destinoVacio(vacio, m);
+                if(destino < 0) continue;
+                Tablero64 vecino = moverVacio(t, destino);
+                if(distancia(vecino) == d - 1) {
+                    resultado.movimientos.push_back((Movimiento)m);
+                    t = vecino;
+                    break;
+                }
             }
+            resultado.nodosExpandidos++;
+            d--;
         }
+        resultado.encontrada = true;
+        resultado.fin = FIN_SOLUCION;
+        return resultado;
     }
-    
-    int inversiones = 0;
-    for(int i = 0; i < arr.size(); i++) {
-        for(int j = i + 1; j < arr.size(); j++) {
-            if(arr[i] > arr[j]) inversiones++;
+};
+
+// la tabla de distancias solo existe para el 3x3
+template <int W>
+struct ConsultaTabla {
+    template <class Tablero>
+    static bool resolver(const TablaDistancias*, const Tablero&, ResultadoBusqueda&) { return false; }
+};
+
+template <>
+struct ConsultaTabla<3> {
+    static bool resolver(const TablaDistancias* tabla, Tablero64 inicio, ResultadoBusqueda& resultado) {
+        if(tabla == NULL) return false;
+        resultado = tabla->resolver(inicio);
+        return true;
+    }
+};
+
+// motores de busqueda disponibles
+enum MotorBusqueda { MOTOR_AESTRELLA, MOTOR_IDA, MOTOR_TABLA, MOTOR_AMBOS, MOTOR_BIDIRECCIONAL, MOTOR_HDA };
+
+struct OpcionesBusqueda {
+    MotorBusqueda motor;
+    bool conflictoLineal;
+    bool patrones;                // bases de patrones para el 4x4
+    int hilos;                    // hilos de MOTOR_HDA (0 = todos los nucleos)
+    const TablaDistancias* tabla; // solo para MOTOR_TABLA (ya cargada)
+    LimitesBusqueda limites;      // presupuesto de cada busqueda
+
+    OpcionesBusqueda() : motor(MOTOR_AESTRELLA), conflictoLineal(true), patrones(true), hilos(0), tabla(NULL) {}
+};
+
+// solucionador con todo su estado (tablas y memoria de busqueda) para un objetivo fijo
+// cada hilo del modo lote tiene el suyo y lo reusa para todos sus tableros
+template <class Heuristica>
+class Solucionador {
+public:
+    static const int W = Heuristica::ANCHO;
+    typedef typename Codificacion<W>::Tablero Tablero;
+
+private:
+    Tablero meta;
+    OpcionesBusqueda opciones;
+    Heuristica heuristica;
+    ContextoAEstrella<W, ListaAbiertaCubetas<uint32_t>> contexto;
+    BusquedaBidireccional<Heuristica> bidireccional;
+    TablaHeuristica<W> haciaInicio; // heuristica de la busqueda hacia atras
+    BusquedaHDA<Heuristica> hda;
+
+public:
+    Solucionador(const Tablero& objetivo, const OpcionesBusqueda& op, const Heuristica& h)
+        : meta(objetivo), opciones(op), heuristica(h), hda(objetivo) {}
+
+    ResultadoBusqueda resolver(const Tablero& inicio) {
+        LimitesBusqueda limites = opciones.limites;
+        limites.empezar();
+        ResultadoBusqueda resultado = buscar(inicio, limites);
+        resultado.estadisticas.segundos = limites.transcurrido();
+        return resultado;
+    }
+
+private:
+    ResultadoBusqueda buscar(const Tablero& inicio, const LimitesBusqueda& limites) {
+        if(opciones.motor == MOTOR_IDA) {
+            BusquedaIDA<Heuristica> ida(heuristica, meta);
+            return ida.resolver(inicio, limites);
+        }
+        if(opciones.motor == MOTOR_HDA) {
+            return hda.resolver(inicio, heuristica, opciones.hilos, limites);
         }
+        if(opciones.motor == MOTOR_BIDIRECCIONAL) {
+            haciaInicio.compilar(inicio, opciones.conflictoLineal);
+            return bidireccional.resolver(inicio, meta, heuristica, haciaInicio, limites);
+        }
+        ResultadoBusqueda resultado;
+        if(opciones.motor == MOTOR_TABLA && ConsultaTabla<W>::resolver(opciones.tabla, inicio, resultado)) {
+            return resultado;
+        }
+        return buscarAEstrella(inicio, meta, heuristica, contexto, limites);
     }
-    
-    return inversiones;
+};
+
+// la base de patrones del 4x4 tarda unos segundos en construirse, asi que se
+// arma una sola vez por proceso (antes de lanzar hilos) y se comparte
+const BaseDatosPatrones& obtenerPatrones(Codificacion<4>::Tablero meta) {
+    static BaseDatosPatrones base;
+    if(!base.construida(meta)) {
+        cerr << "Construyendo bases de datos de patrones 5-5-5 para el 4x4..." << endl;
+        base.construir(meta);
+    }
+    return base;
 }
 
-bool puedenConectarse(const vector<vector<int>>& inicial, const vector<vector<int>>& objetivo) {
-    int inv1 = contarInversiones(inicial);
-    int inv2 = contarInversiones(objetivo);
-    // ambas deben tener la misma paridad (ambas pares o ambas impares)
-    return (inv1 % 2) == (inv2 % 2);
+// llama a accion(heuristica) con la heuristica que corresponde al ancho del tablero
+template <class Accion>
+void conHeuristica(const vector<vector<int>>& objetivo, const OpcionesBusqueda& opciones, Accion& accion) {
+    int ancho = (int)objetivo.size();
+    if(ancho == 4 && opciones.patrones) {
+        HeuristicaPatrones h(&obtenerPatrones(Codificacion<4>::desdeMatriz(objetivo)));
+        accion(h);
+    } else if(ancho == 4) {
+        TablaHeuristica<4> h;
+        h.compilar(Codificacion<4>::desdeMatriz(objetivo), opciones.conflictoLineal);
+        accion(h);
+    } else if(ancho == 5) {
+        TablaHeuristica<5> h;
+        h.compilar(Codificacion<5>::desdeMatriz(objetivo), opciones.conflictoLineal);
+        accion(h);
+    } else {
+        TablaHeuristica<3> h;
+        h.compilar(Codificacion<3>::desdeMatriz(objetivo), opciones.conflictoLineal);
+        accion(h);
+    }
 }
 
-// verificar si dos tableros son iguales
-bool sonIguales(const vector<vector<int>>& a, const vector<vector<int>>& b) {
-    for(int i = 0; i < 3; i++) {
-        for(int j = 0; j < 3; j++) {
-            if(a[i][j] != b[i][j]) return false;
+struct AccionResolver {
+    const vector<vector<int>>& inicial;
+    const vector<vector<int>>& objetivo;
+    const OpcionesBusqueda& opciones;
+    ResultadoBusqueda resultado;
+
+    AccionResolver(const vector<vector<int>>& i, const vector<vector<int>>& o, const OpcionesBusqueda& op)
+        : inicial(i), objetivo(o), opciones(op) {}
+
+    template <class Heuristica>
+    void operator()(const Heuristica& h) {
+        typedef Codificacion<Heuristica::ANCHO> C;
+        Solucionador<Heuristica> solucionador(C::desdeMatriz(objetivo), opciones, h);
+        resultado = solucionador.resolver(C::desdeMatriz(inicial));
+    }
+};
+
+ResultadoBusqueda resolverPuzzle(vector<vector<int>>& inicial, vector<vector<int>>& objetivo, const OpcionesBusqueda& opciones) {
+    AccionResolver accion(inicial, objetivo, opciones);
+    conHeuristica(objetivo, opciones, accion);
+    return accion.resultado;
+}
+
+const char* nombreFin(FinBusqueda fin) {
+    static const char* nombres[] = {"solucion", "sin_solucion", "memoria", "tiempo"};
+    return nombres[fin];
+}
+
+void imprimirEstadisticas(ostream& out, const ResultadoBusqueda& r) {
+    const EstadisticasBusqueda& e = r.estadisticas;
+    out << "\n--- Estadisticas de la busqueda ---" << endl;
+    out << "Fin:                " << nombreFin(r.fin) << endl;
+    out << "Nodos generados:    " << e.generados << endl;
+    out << "Nodos expandidos:   " << r.nodosExpandidos << endl;
+    out << "Sacados obsoletos:  " << e.obsoletos << endl;
+    out << "Pico lista abierta: " << e.picoAbierta << endl;
+    out << "Pico visitados:     " << e.picoCerrada << endl;
+    out << "Pedidos al heap:    " << e.asignaciones << " (la arena atendio " << e.pedidosArena << ")" << endl;
+    out << "Memoria estimada:   " << fixed << setprecision(1) << e.picoBytes / 1048576.0 << " MB" << endl;
+    out << "Tiempo:             " << setprecision(3) << e.segundos << " s" << endl;
+    out << "Nodos/s:            " << setprecision(0) << (e.segundos > 0 ? r.nodosExpandidos / e.segundos : 0.0) << endl;
+}
+
+void escribirEstadisticasJSON(ostream& out, const ResultadoBusqueda& r) {
+    const EstadisticasBusqueda& e = r.estadisticas;
+    out << "{\"fin\": \"" << nombreFin(r.fin) << "\""
+        << ", \"movimientos\": " << (r.encontrada ? (long long)r.movimientos.size() : -1LL)
+        << ", \"generados\": " << e.generados
+        << ", \"expandidos\": " << r.nodosExpandidos
+        << ", \"obsoletos\": " << e.obsoletos
+        << ", \"pico_abierta\": " << e.picoAbierta
+        << ", \"pico_visitados\": " << e.picoCerrada
+        << ", \"bytes\": " << e.picoBytes
+        << ", \"asignaciones\": " << e.asignaciones << ", \"pedidos_arena\": " << e.pedidosArena
+        << ", \"segundos\": " << fixed << setprecision(6) << e.segundos
+        << ", \"nodos_por_segundo\": " << setprecision(0) << (e.segundos > 0 ? r.nodosExpandidos / e.segundos : 0.0)
+        << "}" << endl;
+}
+
+// aplica los movimientos sobre el tablero inicial y dice si se llega a la meta
+bool verificarSolucion(vector<vector<int>> tablero, const vector<vector<int>>& objetivo, const vector<Movimiento>& movimientos) {
+    int ancho = (int)tablero.size();
+    int fila = filaDelVacio(tablero);
+    int col = (int)(find(tablero[fila].begin(), tablero[fila].end(), 0) - tablero[fila].begin());
+    int df[] = {-1, 1, 0, 0};
+    int dc[] = {0, 0, -1, 1};
+    for(size_t i = 0; i < movimientos.size(); i++) {
+        int nf = fila + df[movimientos[i]];
+        int nc = col + dc[movimientos[i]];
+        if(nf < 0 || nf >= ancho || nc < 0 || nc >= ancho) return false;
+        swap(tablero[fila][col], tablero[nf][nc]);
+        fila = nf;
+        col = nc;
+    }
+    return tablero == objetivo;
+}
+
+// tablero aleatorio con la misma paridad que la meta (siempre resoluble)
+vector<vector<int>> generarTableroAleatorio(mt19937& rng, const vector<vector<int>>& objetivo) {
+    int ancho = (int)objetivo.size();
+    vector<int> fichas;
+    for(int k = 0; k < ancho * ancho; k++) fichas.push_back(k);
+    vector<vector<int>> tablero(ancho, vector<int>(ancho));
+    do {
+        shuffle(fichas.begin(), fichas.end(), rng);
+        for(int k = 0; k < ancho * ancho; k++) tablero[k / ancho][k % ancho] = fichas[k];
+    } while(!puedenConectarse(tablero, objetivo));
+    return tablero;
+}
+
+// benchmark de la lista abierta: resuelve los mismos tableros aleatorios con el
+// heap de la STL y con las cubetas, y compara tiempo y nodos por segundo
+template <class ListaAbierta>
+void medirListaAbierta(const char* nombre, const vector<Tablero64>& tableros, Tablero64 meta, const TablaHeuristica<3>& heuristica) {
+    long long nodos = 0, movimientos = 0;
+    chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+    for(size_t i = 0; i < tableros.size(); i++) {
+        ResultadoBusqueda r = buscarAEstrella<ListaAbierta>(tableros[i], meta, heuristica);
+        nodos += r.nodosExpandidos;
+        movimientos += r.movimientos.size();
+    }
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    cout << nombre << ": " << fixed << setprecision(3) << segundos << " s | "
+         << nodos << " nodos expandidos | "
+         << setprecision(0) << nodos / segundos << " nodos/s | "
+         << movimientos << " movimientos en total" << endl;
+}
+
+void benchmarkListaAbierta(const vector<vector<int>>& objetivo, int cantidad, unsigned semilla) {
+    mt19937 rng(semilla);
+    vector<Tablero64> tableros;
+    for(int i = 0; i < cantidad; i++) tableros.push_back(empaquetar(generarTableroAleatorio(rng, objetivo)));
+
+    Tablero64 meta = empaquetar(objetivo);
+    TablaHeuristica<3> heuristica;
+    heuristica.compilar(meta, true);
+
+    cout << "=== BENCHMARK LISTA ABIERTA (" << cantidad << " tableros, semilla " << semilla << ") ===" << endl;
+    medirListaAbierta<ListaAbiertaHeap<uint32_t>>("Heap binario", tableros, meta, heuristica);
+    medirListaAbierta<ListaAbiertaCubetas<uint32_t>>("Cubetas f/g ", tableros, meta, heuristica);
+}
+
+// BENCHMARK DE MOTORES
+// corpus fijo para medir cada cambio contra la misma base: todos los tableros de la
+// profundidad maxima (los mas dificiles) + una muestra con semilla de cada profundidad.
+// la tabla de distancias da la longitud optima de cada tablero, asi se verifica
+// tambien que cada motor devuelva una solucion valida y optima.
+
+struct TableroBench {
+    Tablero64 tablero;
+    int optimo;
+};
+
+vector<TableroBench> armarCorpusBench(const TablaDistancias& tabla, const vector<vector<int>>& objetivo,
+                                      int porProfundidad, unsigned semilla, int& profundidadMaxima) {
+    // recorrer las 9! permutaciones y quedarse con las resolubles, agrupadas por distancia
+    vector<vector<Tablero64>> porDistancia;
+    vector<int> celdas;
+    for(int k = 0; k < 9; k++) celdas.push_back(k);
+    vector<vector<int>> tablero(3, vector<int>(3));
+    do {
+        for(int k = 0; k < 9; k++) tablero[k / 3][k % 3] = celdas[k];
+        if(!puedenConectarse(tablero, objetivo)) continue;
+        Tablero64 t = empaquetar(tablero);
+        int d = tabla.distancia(t);
+        if(d >= (int)porDistancia.size()) porDistancia.resize(d + 1);
+        porDistancia[d].push_back(t);
+    } while(next_permutation(celdas.begin(), celdas.end()));
+
+    profundidadMaxima = (int)porDistancia.size() - 1;
+    vector<TableroBench> corpus;
+    mt19937 rng(semilla);
+    for(int d = 1; d <= profundidadMaxima; d++) {
+        vector<Tablero64>& grupo = porDistancia[d];
+        size_t cantidad = grupo.size();
+        if(d < profundidadMaxima) {
+            shuffle(grupo.begin(), grupo.end(), rng);
+            cantidad = min(cantidad, (size_t)porProfundidad);
+        }
+        for(size_t i = 0; i < cantidad; i++) {
+            TableroBench b;
+            b.tablero = grupo[i];
+            b.optimo = d;
+            corpus.push_back(b);
+        }
+    }
+    return corpus;
+}
+
+// percentil sobre un vector ya ordenado (metodo del rango mas cercano)
+double percentil(const vector<double>& ordenados, double q) {
+    if(ordenados.empty()) return 0;
+    size_t k = (size_t)ceil(q * ordenados.size());
+    return ordenados[k > 0 ? k - 1 : 0];
+}
+
+// memoria maxima del proceso en MB (acumulada: incluye los motores anteriores)
+double picoMemoriaProceso() {
+#ifndef _WIN32
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    return uso.ru_maxrss / 1024.0; // Linux lo da en KB
+#else
+    return 0;
+#endif
+}
+
+void medirMotor(const char* nombre, MotorBusqueda motor, const vector<TableroBench>& corpus,
+                const vector<vector<int>>& objetivo, OpcionesBusqueda opciones) {
+    opciones.motor = motor;
+    TablaHeuristica<3> heuristica;
+    heuristica.compilar(empaquetar(objetivo), opciones.conflictoLineal);
+    Solucionador<TablaHeuristica<3>> solucionador(empaquetar(objetivo), opciones, heuristica);
+
+    vector<double> latencias;
+    long long nodos = 0, asignaciones = 0;
+    size_t picoBytes = 0;
+    int errores = 0;
+    double total = 0;
+    for(size_t i = 0; i < corpus.size(); i++) {
+        ResultadoBusqueda r = solucionador.resolver(corpus[i].tablero);
+        latencias.push_back(r.estadisticas.segundos * 1000.0);
+        total += r.estadisticas.segundos;
+        nodos += r.nodosExpandidos;
+        asignaciones += r.estadisticas.asignaciones;
+        picoBytes = max(picoBytes, r.estadisticas.picoBytes);
+        Tablero64 t = corpus[i].tablero;
+        for(size_t k = 0; k < r.movimientos.size(); k++) {
+            int destino = destinoVacio(posVacio(t), r.movimientos[k]);
+            if(destino < 0) break;
+            t = moverVacio(t, destino);
         }
+        if(!r.encontrada || (int)r.movimientos.size() != corpus[i].optimo || t != empaquetar(objetivo)) errores++;
+    }
+    sort(latencias.begin(), latencias.end());
+
+    cout << left << setw(8) << nombre << right << fixed
+         << setprecision(3) << setw(12) << percentil(latencias, 0.5)
+         << setw(12) << percentil(latencias, 0.99)
+         << setw(12) << latencias.back()
+         << setprecision(0) << setw(14) << (total > 0 ? nodos / total : 0.0)
+         << setprecision(1) << setw(12) << picoBytes / 1048576.0
+         << setw(12) << picoMemoriaProceso()
+         << setw(12) << asignaciones / corpus.size()
+         << setw(9) << errores << endl;
+}
+
+void benchmarkMotores(const TablaDistancias& tabla, const vector<vector<int>>& objetivo, int porProfundidad,
+                      unsigned semilla, const OpcionesBusqueda& opciones) {
+    int profundidadMaxima = 0;
+    vector<TableroBench> corpus = armarCorpusBench(tabla, objetivo, porProfundidad, semilla, profundidadMaxima);
+    size_t dificiles = 0;
+    for(size_t i = 0; i < corpus.size(); i++) {
+        if(corpus[i].optimo == profundidadMaxima) dificiles++;
+    }
+
+    cout << "=== BENCHMARK DE MOTORES ===" << endl;
+    cout << corpus.size() << " tableros: los " << dificiles << " de " << profundidadMaxima
+         << " movimientos + hasta " << porProfundidad << " por profundidad (semilla " << semilla << ")" << endl;
+    cout << "latencias en ms; memoria = estimada por busqueda / pico del proceso en MB; asig/tab = pedidos al heap" << endl;
+    cout << "por tablero; errores = sin solucion optima" << endl;
+    cout << left << setw(8) << "motor" << right << setw(12) << "mediana" << setw(12) << "p99" << setw(12) << "max"
+         << setw(14) << "nodos/s" << setw(12) << "mem busq" << setw(12) << "mem proc" << setw(12) << "asig/tab" << setw(9) << "errores" << endl;
+
+    medirMotor("tabla", MOTOR_TABLA, corpus, objetivo, opciones);
+    medirMotor("astar", MOTOR_AESTRELLA, corpus, objetivo, opciones);
+    medirMotor("ida", MOTOR_IDA, corpus, objetivo, opciones);
+    medirMotor("bi", MOTOR_BIDIRECCIONAL, corpus, objetivo, opciones);
+    medirMotor("hda", MOTOR_HDA, corpus, objetivo, opciones);
+}
+
+// MODO LOTE
+// lee tableros (ancho*ancho numeros por linea) de un archivo o de la entrada estandar
+// y los resuelve en paralelo. la salida va en el mismo orden que la entrada, una linea
+// por tablero: "movimientos secuencia nodos_expandidos" (A=arriba B=abajo I=izq D=der)
+// o "-1 imposible 0" / "-1 invalido 0"
+
+const size_t TABLEROS_POR_BLOQUE = 16384;
+
+// verdadero si el tablero es una permutacion de 0..N-1
+bool esPermutacion(const vector<vector<int>>& tablero) {
+    int ancho = (int)tablero.size();
+    int n = ancho * ancho;
+    uint32_t vistos = 0;
+    for(int k = 0; k < n; k++) {
+        int valor = tablero[k / ancho][k % ancho];
+        if(valor < 0 || valor >= n || (vistos & (1u << valor))) return false;
+        vistos |= 1u << valor;
     }
     return true;
 }
 
-// funcion para resolver el puzzle usando A*
-// todos trabajamos en esta parte
-vector<string> resolverPuzzle(vector<vector<int>>& inicial, vector<vector<int>>& objetivo) {
-    
-    priority_queue<Estado, vector<Estado>, greater<Estado>> pq;
-    set<string> visitados;
-    
-    // encontrar posicion inicial del espacio vacio
-    int x0, y0;
-    for(int i = 0; i < 3; i++) {
-        for(int j = 0; j < 3; j++) {
-            if(inicial[i][j] == 0) {
-                x0 = i;
-                y0 = j;
+// convierte una linea en un tablero; falso si no es una permutacion de 0..N-1
+bool leerTableroLinea(const string& linea, vector<vector<int>>& tablero) {
+    int ancho = (int)tablero.size();
+    istringstream in(linea);
+    for(int k = 0; k < ancho * ancho; k++) {
+        if(!(in >> tablero[k / ancho][k % ancho])) return false;
+    }
+    return esPermutacion(tablero);
+}
+
+string formatearResultadoLote(const ResultadoBusqueda& r) {
+    static const char letras[] = {'A', 'B', 'I', 'D'};
+    if(!r.encontrada) {
+        string motivo = (r.fin == FIN_MEMORIA) ? "memoria" : (r.fin == FIN_TIEMPO) ? "tiempo" : "-";
+        return "-1 " + motivo + " " + to_string(r.nodosExpandidos);
+    }
+    string movs;
+    for(size_t i = 0; i < r.movimientos.size(); i++) movs += letras[r.movimientos[i]];
+    if(movs.empty()) movs = "-";
+    return to_string(r.movimientos.size()) + " " + movs + " " + to_string(r.nodosExpandidos);
+}
+
+template <class Heuristica>
+void resolverLote(istream& entrada, const vector<vector<int>>& objetivo, const OpcionesBusqueda& opciones,
+                  int numHilos, const Heuristica& heuristica) {
+    typedef Codificacion<Heuristica::ANCHO> C;
+    if(numHilos <= 0) numHilos = (int)thread::hardware_concurrency();
+    if(numHilos <= 0) numHilos = 1;
+
+    vector<Solucionador<Heuristica>> solucionadores(numHilos, Solucionador<Heuristica>(C::desdeMatriz(objetivo), opciones, heuristica));
+
+    vector<string> lineas;
+    vector<string> salidas;
+    long long total = 0;
+    chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+
+    string linea;
+    bool fin = false;
+    while(!fin) {
+        // leer un bloque de lineas
+        lineas.clear();
+        while(lineas.size() < TABLEROS_POR_BLOQUE) {
+            if(!getline(entrada, linea)) {
+                fin = true;
+                break;
             }
+            if(linea.find_first_not_of(" \t\r") == string::npos) continue;
+            lineas.push_back(linea);
+        }
+        if(lineas.empty()) break;
+        salidas.assign(lineas.size(), string());
+
+        // repartir el bloque entre los hilos en porciones chicas
+        atomic<size_t> siguiente(0);
+        vector<thread> hilos;
+        for(int h = 0; h < numHilos; h++) {
+            hilos.push_back(thread([&, h]() {
+                vector<vector<int>> tablero(objetivo.size(), vector<int>(objetivo.size()));
+                const size_t PORCION = 64;
+                while(true) {
+                    size_t desde = siguiente.fetch_add(PORCION);
+                    if(desde >= lineas.size()) break;
+                    size_t hasta = min(desde + PORCION, lineas.size());
+                    for(size_t k = desde; k < hasta; k++) {
+                        if(!leerTableroLinea(lineas[k], tablero)) {
+                            salidas[k] = "-1 invalido 0";
+                        } else if(!puedenConectarse(tablero, objetivo)) {
+                            salidas[k] = "-1 imposible 0";
+                        } else {
+                            salidas[k] = formatearResultadoLote(solucionadores[h].resolver(C::desdeMatriz(tablero)));
+                        }
+                    }
+                }
+            }));
         }
+        for(size_t h = 0; h < hilos.size(); h++) hilos[h].join();
+
+        for(size_t k = 0; k < salidas.size(); k++) cout << salidas[k] << '\n';
+        total += lineas.size();
     }
-    
-    Estado estadoInicial;
-    estadoInicial.tablero = inicial;
-    estadoInicial.x = x0;
-    estadoInicial.y = y0;
-    estadoInicial.g = 0;
-    estadoInicial.h = calcularHeuristica(inicial, objetivo);
-    estadoInicial.camino = "";
-    
-    pq.push(estadoInicial);
-    
-    // direcciones: arriba, abajo, izquierda, derecha
-    int dx[] = {-1, 1, 0, 0};
-    int dy[] = {0, 0, -1, 1};
-    string movimientos[] = {"ARRIBA", "ABAJO", "IZQUIERDA", "DERECHA"};
-    
-    int iteraciones = 0;
-    int maxIteraciones = 200000;
-    
-    while(!pq.empty() && iteraciones < maxIteraciones) {
-        iteraciones++;
-        Estado actual = pq.top();
-        pq.pop();
-        
-        // verificar si llegamos al objetivo
-        if(sonIguales(actual.tablero, objetivo)) {
-            vector<string> resultado;
-            resultado.push_back(actual.camino);
-            return resultado;
+    cout.flush();
+
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    cerr << total << " tableros en " << fixed << setprecision(3) << segundos << " s con "
+         << numHilos << " hilos (" << setprecision(0) << (segundos > 0 ? total / segundos : 0.0)
+         << " tableros/s)" << endl;
+}
+
+struct AccionLote {
+    istream& entrada;
+    const vector<vector<int>>& objetivo;
+    const OpcionesBusqueda& opciones;
+    int numHilos;
+
+    AccionLote(istream& e, const vector<vector<int>>& o, const OpcionesBusqueda& op, int hilos)
+        : entrada(e), objetivo(o), opciones(op), numHilos(hilos) {}
+
+    template <class Heuristica>
+    void operator()(const Heuristica& h) {
+        resolverLote(entrada, objetivo, opciones, numHilos, h);
+    }
+};
+
+// imprime N tableros aleatorios resolubles, uno por linea (para probar el modo lote)
+void generarCorpus(const vector<vector<int>>& objetivo, int cantidad, unsigned semilla) {
+    mt19937 rng(semilla);
+    int ancho = (int)objetivo.size();
+    for(int i = 0; i < cantidad; i++) {
+        vector<vector<int>> t = generarTableroAleatorio(rng, objetivo);
+        for(int k = 0; k < ancho * ancho; k++) cout << t[k / ancho][k % ancho] << (k < ancho * ancho - 1 ? ' ' : '\n');
+    }
+}
+
+// objetivo de cada tamaño: el 3x3 es el del enunciado; los demas el orden clasico
+// (1, 2, ..., N-1 y el vacio al final)
+vector<vector<int>> objetivoPorDefecto(int ancho) {
+    vector<vector<int>> objetivo(ancho, vector<int>(ancho));
+    if(ancho == 3) {
+        // configuracion objetivo fija (segun el problema)
+        objetivo[0][0] = 1; objetivo[0][1] = 2; objetivo[0][2] = 3;
+        objetivo[1][0] = 8; objetivo[1][1] = 0; objetivo[1][2] = 4;
+        objetivo[2][0] = 7; objetivo[2][1] = 6; objetivo[2][2] = 5;
+    } else {
+        for(int k = 0; k < ancho * ancho; k++) objetivo[k / ancho][k % ancho] = (k + 1) % (ancho * ancho);
+    }
+    return objetivo;
+}
+
+int main(int argc, char* argv[]) {
+    // el ancho se lee antes que el resto de las opciones porque define el objetivo
+    int ancho = 3;
+    for(int i = 1; i + 1 < argc; i++) {
+        if(string(argv[i]) == "--ancho") ancho = atoi(argv[i + 1]);
+    }
+    if(ancho < 3 || ancho > 5) {
+        cout << "Ancho no soportado (use 3, 4 o 5)." << endl;
+        return 1;
+    }
+
+    vector<vector<int>> inicial(ancho, vector<int>(ancho));
+    vector<vector<int>> objetivo = objetivoPorDefecto(ancho);
+
+    // opciones de linea de comandos
+    OpcionesBusqueda opciones;
+    // los tableros grandes no caben en memoria con A*: por defecto van con IDA*
+    if(ancho > 3) opciones.motor = MOTOR_IDA;
+    string rutaTabla = "distancias_8puzzle.bin";
+    TablaDistancias tabla;
+    bool modoLote = false;
+    string archivoLote;
+    int numHilos = 0;
+    bool mostrarEstadisticas = false;
+    string archivoJSON;
+    int benchPorProfundidad = 0;
+    unsigned benchSemilla = 12345;
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if(arg == "--ancho") i++;
+        else if(arg == "--sin-conflicto") opciones.conflictoLineal = false;
+        else if(arg == "--sin-patrones") opciones.patrones = false;
+        else if(arg == "--motor" && i + 1 < argc) {
+            string motor = argv[++i];
+            if(motor == "ida") opciones.motor = MOTOR_IDA;
+            else if(motor == "tabla") opciones.motor = MOTOR_TABLA;
+            else if(motor == "ambos") opciones.motor = MOTOR_AMBOS;
+            else if(motor == "bi") opciones.motor = MOTOR_BIDIRECCIONAL;
+            else if(motor == "hda") opciones.motor = MOTOR_HDA;
+            else opciones.motor = MOTOR_AESTRELLA;
         }
-        
-        string key = estadoAString(actual.tablero);
-        
-        // si ya visitamos este estado, continuar
-        if(visitados.count(key) > 0) continue;
-        
-        visitados.insert(key);
-        
-        // generar estados vecinos
-        for(int i = 0; i < 4; i++) {
-            int nx = actual.x + dx[i];
-            int ny = actual.y + dy[i];
-            
-            // verificar limites
-            if(nx >= 0 && nx < 3 && ny >= 0 && ny < 3) {
-                Estado nuevo;
-                nuevo.tablero = actual.tablero;
-                swap(nuevo.tablero[actual.x][actual.y], nuevo.tablero[nx][ny]);
-                nuevo.x = nx;
-                nuevo.y = ny;
-                nuevo.g = actual.g + 1;
-                nuevo.h = calcularHeuristica(nuevo.tablero, objetivo);
-                nuevo.camino = actual.camino + movimientos[i] + " -> ";
-                
-                string newKey = estadoAString(nuevo.tablero);
-                if(visitados.count(newKey) == 0) {
-                    pq.push(nuevo);
-                }
+        else if(arg == "--tabla" && i + 1 < argc) rutaTabla = argv[++i];
+        else if(arg == "--generar-tabla") {
+            if(!TablaDistancias::generar(rutaTabla, empaquetar(objetivoPorDefecto(3)))) {
+                cout << "No se pudo escribir " << rutaTabla << endl;
+                return 1;
+            }
+            cout << "Tabla de distancias guardada en " << rutaTabla << endl;
+            return 0;
+        }
+        else if(arg == "--hilos" && i + 1 < argc) numHilos = atoi(argv[++i]);
+        else if(arg == "--memoria" && i + 1 < argc) {
+            double megas = atof(argv[++i]);
+            if(!(megas > 0)) {
+                cout << "Presupuesto de memoria invalido: " << argv[i] << " (use MB mayores que cero)." << endl;
+                return 1;
+            }
+            opciones.limites.bytesMaximos = (size_t)(megas * 1048576.0);
+        }
+        else if(arg == "--tiempo" && i + 1 < argc) opciones.limites.segundosMaximos = atof(argv[++i]);
+        else if(arg == "--estadisticas") mostrarEstadisticas = true;
+        else if(arg == "--json" && i + 1 < argc) archivoJSON = argv[++i];
+        else if(arg == "--lote") {
+            modoLote = true;
+            if(i + 1 < argc && argv[i + 1][0] != '-') archivoLote = argv[++i];
+        }
+        else if(arg == "--generar-corpus") {
+            int cantidad = (i + 1 < argc) ? atoi(argv[i + 1]) : 10000;
+            unsigned semilla = (i + 2 < argc) ? (unsigned)atoi(argv[i + 2]) : 12345;
+            generarCorpus(objetivo, cantidad, semilla);
+            return 0;
+        }
+        else if(arg == "--bench") {
+            benchPorProfundidad = 20;
+            if(i + 1 < argc && argv[i + 1][0] != '-') benchPorProfundidad = atoi(argv[++i]);
+            if(i + 1 < argc && argv[i + 1][0] != '-') benchSemilla = (unsigned)atoi(argv[++i]);
+        }
+        else if(arg == "--bench-abierta") {
+            int cantidad = (i + 1 < argc) ? atoi(argv[i + 1]) : 200;
+            unsigned semilla = (i + 2 < argc) ? (unsigned)atoi(argv[i + 2]) : 12345;
+            benchmarkListaAbierta(objetivoPorDefecto(3), cantidad, semilla);
+            return 0;
+        }
+    }
+
+    if(opciones.motor == MOTOR_TABLA) {
+        if(ancho != 3) {
+            cout << "La tabla de distancias solo existe para el 3x3, se usa IDA*." << endl;
+            opciones.motor = MOTOR_IDA;
+        } else if(!tabla.cargarOGenerar(rutaTabla, empaquetar(objetivo))) {
+            cout << "No se pudo cargar ni generar " << rutaTabla << ", se usa A*." << endl;
+            opciones.motor = MOTOR_AESTRELLA;
+        } else {
+            opciones.tabla = &tabla;
+        }
+    }
+
+    opciones.hilos = numHilos;
+
+    if(benchPorProfundidad > 0) {
+        if(ancho != 3 || !tabla.cargarOGenerar(rutaTabla, empaquetar(objetivo))) {
+            cout << "El benchmark necesita el 3x3 y la tabla de distancias (" << rutaTabla << ")." << endl;
+            return 1;
+        }
+        opciones.tabla = &tabla;
+        benchmarkMotores(tabla, objetivo, benchPorProfundidad, benchSemilla, opciones);
+        return 0;
+    }
+
+    if(modoLote) {
+        if(opciones.motor == MOTOR_AMBOS) opciones.motor = MOTOR_AESTRELLA;
+        // con HDA* los hilos se usan dentro de cada tablero, el lote va de a uno
+        if(opciones.motor == MOTOR_HDA) numHilos = 1;
+        if(archivoLote.empty()) {
+            AccionLote accion(cin, objetivo, opciones, numHilos);
+            conHeuristica(objetivo, opciones, accion);
+        } else {
+            ifstream archivo(archivoLote.c_str());
+            if(!archivo) {
+                cerr << "No se pudo abrir " << archivoLote << endl;
+                return 1;
             }
+            AccionLote accion(archivo, objetivo, opciones, numHilos);
+            conHeuristica(objetivo, opciones, accion);
         }
+        return 0;
     }
-    
-    vector<string> vacio;
-    return vacio; // no se encontro solucion
-}
 
-int main() {
-    cout << "=== SOLUCIONADOR DE 8-PUZZLE ===" << endl;
+    cout << "=== SOLUCIONADOR DE " << (ancho * ancho - 1) << "-PUZZLE ===" << endl;
     cout << "Ingrese la configuracion inicial (use 0 para el espacio vacio):" << endl;
-    
-    vector<vector<int>> inicial(3, vector<int>(3));
-    vector<vector<int>> objetivo(3, vector<int>(3));
-    
+
     // leer configuracion inicial
     cout << "Ingrese los numeros fila por fila:" << endl;
-    for(int i = 0; i < 3; i++) {
-        for(int j = 0; j < 3; j++) {
-            cin >> inicial[i][j];
+    for(int i = 0; i < ancho; i++) {
+        for(int j = 0; j < ancho; j++) {
+            if(!(cin >> inicial[i][j])) {
+                cerr << "Entrada incompleta: se esperaban " << ancho * ancho << " numeros." << endl;
+                return 1;
+            }
         }
     }
-    
-    // configuracion objetivo fija (segun el problema)
-    objetivo[0][0] = 1; objetivo[0][1] = 2; objetivo[0][2] = 3;
-    objetivo[1][0] = 8; objetivo[1][1] = 0; objetivo[1][2] = 4;
-    objetivo[2][0] = 7; objetivo[2][1] = 6; objetivo[2][2] = 5;
-    
+    if(!esPermutacion(inicial)) {
+        cerr << "Tablero invalido: debe contener cada numero de 0 a " << ancho * ancho - 1
+             << " exactamente una vez." << endl;
+        return 1;
+    }
+
     cout << "\nEstado inicial:" << endl;
     imprimirTablero(inicial);
-    
+
     cout << "\nEstado objetivo:" << endl;
     imprimirTablero(objetivo);
-    
+
     // verificar si pueden conectarse (misma paridad de inversiones)
     int invInicial = contarInversiones(inicial);
     int invObjetivo = contarInversiones(objetivo);
-    
+
     cout << "\n--- Analisis de Solucionabilidad ---" << endl;
-    
+
     // DEBUG: mostrar secuencia sin el 0
     vector<int> seqInicial, seqObjetivo;
-    for(int i = 0; i < 3; i++) {
-        for(int j = 0; j < 3; j++) {
+    for(int i = 0; i < ancho; i++) {
+        for(int j = 0; j < ancho; j++) {
             if(inicial[i][j] != 0) seqInicial.push_back(inicial[i][j]);
             if(objetivo[i][j] != 0) seqObjetivo.push_back(objetivo[i][j]);
         }
     }
-    
+
     cout << "Secuencia inicial (sin 0): ";
     for(int x : seqInicial) cout << x << " ";
     cout << endl;
-    
+
     cout << "Secuencia objetivo (sin 0): ";
     for(int x : seqObjetivo) cout << x << " ";
     cout << endl;
-    
+
     cout << "Inversiones en estado inicial: " << invInicial << " (" << (invInicial % 2 == 0 ? "PAR" : "IMPAR") << ")" << endl;
     cout << "Inversiones en estado objetivo: " << invObjetivo << " (" << (invObjetivo % 2 == 0 ? "PAR" : "IMPAR") << ")" << endl;
-    
+    if(ancho % 2 == 0) {
+        cout << "Fila del vacio (inicial / objetivo): " << filaDelVacio(inicial) << " / " << filaDelVacio(objetivo) << endl;
+    }
+
     if(!puedenConectarse(inicial, objetivo)) {
         cout << "\n=== IMPOSIBLE RESOLVER ===" << endl;
         cout << "Las configuraciones tienen diferente paridad de inversiones." << endl;
         cout << "Matematicamente NO existe solucion para este puzzle." << endl;
         return 0;
     }
-    
+
     cout << "Las configuraciones son compatibles. Buscando solucion..." << endl;
     cout << "(Esto puede tardar unos segundos...)" << endl;
-    
-    vector<string> solucion = resolverPuzzle(inicial, objetivo);
-    
-    if(solucion.empty()) {
+
+    ResultadoBusqueda solucion;
+    if(opciones.motor == MOTOR_AMBOS) {
+        // correr los dos motores y comparar sus respuestas
+        OpcionesBusqueda opIda = opciones;
+        opIda.motor = MOTOR_IDA;
+        OpcionesBusqueda opAEstrella = opciones;
+        opAEstrella.motor = MOTOR_AESTRELLA;
+        ResultadoBusqueda ida = resolverPuzzle(inicial, objetivo, opIda);
+        solucion = resolverPuzzle(inicial, objetivo, opAEstrella);
+
+        cout << "\n--- Verificacion cruzada A* / IDA* ---" << endl;
+        cout << "A*:   " << solucion.movimientos.size() << " movimientos, "
+             << solucion.nodosExpandidos << " nodos expandidos" << endl;
+        cout << "IDA*: " << ida.movimientos.size() << " movimientos, "
+             << ida.nodosExpandidos << " nodos expandidos" << endl;
+        bool idaValida = verificarSolucion(inicial, objetivo, ida.movimientos);
+        if(solucion.encontrada && ida.encontrada && idaValida && solucion.movimientos.size() == ida.movimientos.size()) {
+            cout << "Ambos motores encontraron una solucion optima de la misma longitud." << endl;
+        } else if(solucion.encontrada && ida.encontrada) {
+            cout << "ADVERTENCIA: los motores no coinciden." << endl;
+        }
+    } else {
+        solucion = resolverPuzzle(inicial, objetivo, opciones);
+    }
+
+    if(!solucion.encontrada) {
         cout << "\n=== NO SE ENCONTRO SOLUCION ===" << endl;
-        cout << "No se pudo encontrar un camino despues de 200,000 iteraciones." << endl;
+        if(solucion.fin == FIN_MEMORIA) {
+            cout << "Se agoto el presupuesto de memoria (" << opciones.limites.bytesMaximos / 1048576.0 << " MB)." << endl;
+            cout << "Pruebe con --memoria MB o con --motor ida (casi no usa memoria)." << endl;
+        } else if(solucion.fin == FIN_TIEMPO) {
+            cout << "Se agoto el tiempo (" << opciones.limites.segundosMaximos << " s). Pruebe con --tiempo S." << endl;
+        } else {
+            cout << "La busqueda recorrio todos los estados alcanzables sin llegar a la meta." << endl;
+        }
     } else {
         cout << "\n=== SOLUCION ENCONTRADA ===" << endl;
-        
-        // contar numero de movimientos
-        int numMovimientos = 0;
-        for(char c : solucion[0]) {
-            if(c == '>') numMovimientos++;
-        }
-        
-        cout << "Numero de movimientos: " << numMovimientos << endl;
+
+        cout << "Numero de movimientos: " << solucion.movimientos.size() << endl;
+        if(opciones.motor == MOTOR_BIDIRECCIONAL) {
+            cout << "Nodos expandidos: " << solucion.expandidosAdelante << " hacia adelante, "
+                 << solucion.expandidosAtras << " hacia atras" << endl;
+        }
         cout << "\nSecuencia de movimientos:" << endl;
-        if(solucion[0].empty()) {
+        if(solucion.movimientos.empty()) {
             cout << "¡Ya esta resuelto!" << endl;
         } else {
-            cout << solucion[0] << "FIN" << endl;
+            for(Movimiento m : solucion.movimientos) {
+                cout << nombreMovimiento(m) << " -> ";
+            }
+            cout << "FIN" << endl;
         }
     }
-    
+
+    if(mostrarEstadisticas) imprimirEstadisticas(cout, solucion);
+    if(archivoJSON == "-") {
+        escribirEstadisticasJSON(cout, solucion);
+    } else if(!archivoJSON.empty()) {
+        ofstream json(archivoJSON.c_str());
+        escribirEstadisticasJSON(json, solucion);
+    }
+
     return 0;
 }
@@ -3,6 +3,36 @@
 #include <cmath>
 #include <vector>
 #include <iomanip>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
+#include <complex>
+#include <memory>
+#include <thread>
+#include <atomic>
+#ifdef __linux__
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <sys/prctl.h>
+#include <linux/futex.h>
+#include <cerrno>
+#include <unistd.h>
+#include <signal.h>
+#include <new>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 using namespace std;
 
@@ -13,15 +43,22 @@ const double lambda1 = 1.85;
 const double lambda2 = 2.79;
 const double lambda3 = 6.48;
 const double L = 1.8;           // constante de Lipschitz
-const double tau_s = 0.004;     // tiempo de muestreo: 250 Hz
+double tau_s = 0.004;           // tiempo de muestreo: 250 Hz (se cambia con --frecuencia)
+
+// Planta del enunciado: G(s) = (7s^2 - 28s + 21)/(s^3 + 9.8s^2 + 30.65s + 30.1)
+// (coeficientes de mayor a menor potencia de s)
+const double numeradorPlanta[] = {7.0, -28.0, 21.0};
+const double denominadorPlanta[] = {1.0, 9.8, 30.65, 30.1};
 
 
 // DERIVADOR DE ORDEN SUPERIOR
 
-struct Derivador {
+// version original (orden 3, pow() en cada llamada); se conserva como referencia
+// para verificar la version por plantilla con --verificar-derivador
+struct DerivadorReferencia {
     double z0, z1, z2, z3; // estados del derivador
     
-    Derivador() : z0(0), z1(0), z2(0), z3(0) {}
+    DerivadorReferencia() : z0(0), z1(0), z2(0), z3(0) {}
     
     // Funcion phi_i segun la formula del PDF
     // phi_i(error) = -lambda_i^(n-i) * L^((i+1)/(n+1)) * |error|^((n-i)/(n+1)) * sign(error)
@@ -80,70 +117,513 @@ struct Derivador {
 };
 
 
-// PLANTA SISO - G(s) = (7s^2 - 28s + 21) / (s^3 + 9.8s^2 + 30.65s + 30.1)
+// TIPOS NUMERICOS
+// el derivador y la planta son plantillas sobre el tipo de los numeros, para ver que
+// pasa en los micros sin double: double (referencia), float y punto fijo.
 
-class PlantaSISO {
+// numero Q(31-F).F en un entero de 32 bits, como se hace en un micro sin FPU: sumas y
+// productos saturan en vez de dar la vuelta, y el producto redondea al LSB mas cercano
+template <int F>
+class Fijo {
 private:
-    // Coeficientes de la ecuacion en diferencias
-    // y[k] = -a1*y[k-1] - a2*y[k-2] - a3*y[k-3] + b0*u[k] + b1*u[k-1] + b2*u[k-2] + b3*u[k-3]
-    double a1, a2, a3;
-    double b0, b1, b2, b3;
+    int32_t crudo;
     
-    // Historico de señales
-    vector<double> y_hist; // salidas anteriores
-    vector<double> u_hist; // entradas anteriores
+    static int32_t saturar(int64_t v) {
+        return (v > INT32_MAX) ? INT32_MAX : (v < INT32_MIN) ? INT32_MIN : (int32_t)v;
+    }
     
 public:
-    PlantaSISO() {
-        // Discretizacion usando transformada bilineal (Tustin) con T = 0.004 s
-        // Aproximacion: s = (2/T) * (z-1)/(z+1)
-        // 
-        // Numerador: 7s^2 - 28s + 21
-        // Denominador: s^3 + 9.8s^2 + 30.65s + 30.1
-        //
-        // Despues de aplicar Tustin y simplificar (calculado con herramientas numericas):
-        
-        // Coeficientes del denominador (para y[k])
-        a1 = -2.88315;
-        a2 = 2.77007;
-        a3 = -0.88691;
-        
-        // Coeficientes del numerador (para u[k])
-        b0 = 0.000895;
-        b1 = 0.001789;
-        b2 = 0.000894;
-        b3 = 0.0;
-        
-        // Inicializar historicos
-        y_hist = {0.0, 0.0, 0.0, 0.0};
-        u_hist = {0.0, 0.0, 0.0, 0.0};
+    static const int BITS_FRACCION = F;
+    
+    Fijo() : crudo(0) {}
+    Fijo(double v) {
+        double escalado = v * (double)(1LL << F);
+        crudo = (escalado >= (double)INT32_MAX) ? INT32_MAX
+              : (escalado <= (double)INT32_MIN) ? INT32_MIN : (int32_t)llround(escalado);
     }
     
-    // Calcular salida de la planta en el instante k
-    double actualizar(double u_k) {
-        // Ecuacion en diferencias:
-        // y[k] = -a1*y[k-1] - a2*y[k-2] - a3*y[k-3] + b0*u[k] + b1*u[k-1] + b2*u[k-2] + b3*u[k-3]
+    static Fijo desdeCrudo(int32_t c) { Fijo f; f.crudo = c; return f; }
+    int32_t getCrudo() const { return crudo; }
+    explicit operator double() const { return crudo / (double)(1LL << F); }
+    
+    Fijo operator+(Fijo o) const { return desdeCrudo(saturar((int64_t)crudo + o.crudo)); }
+    Fijo operator-(Fijo o) const { return desdeCrudo(saturar((int64_t)crudo - o.crudo)); }
+    Fijo operator-() const { return desdeCrudo(saturar(-(int64_t)crudo)); }
+    Fijo operator*(Fijo o) const {
+        int64_t producto = (int64_t)crudo * o.crudo;
+        return desdeCrudo(saturar((producto + (1LL << (F - 1))) >> F));
+    }
+    Fijo& operator+=(Fijo o) { return *this = *this + o; }
+    
+    bool operator<(Fijo o) const { return crudo < o.crudo; }
+    bool operator>(Fijo o) const { return crudo > o.crudo; }
+    bool operator==(Fijo o) const { return crudo == o.crudo; }
+    
+    friend Fijo fabs(Fijo x) { return (x.crudo < 0) ? -x : x; }
+    
+    // raiz cuadrada entera bit a bit: sqrt(c / 2^F) * 2^F = sqrt(c * 2^F)
+    friend Fijo sqrt(Fijo x) {
+        if(x.crudo <= 0) return Fijo();
+        uint64_t v = (uint64_t)x.crudo << F, r = 0, bit = 1ULL << 62;
+        while(bit > v) bit >>= 2;
+        while(bit) {
+            if(v >= r + bit) { v -= r + bit; r = (r >> 1) + bit; }
+            else r >>= 1;
+            bit >>= 2;
+        }
+        return desdeCrudo((int32_t)r);
+    }
+    
+    // sin version entera: solo la usa el derivador de orden 2
+    friend Fijo cbrt(Fijo x) { return Fijo(std::cbrt((double)x)); }
+};
+
+typedef Fijo<24> Q24; // Q7.24: rango +-128, resolucion 6e-8
+
+// nombre de cada tipo y el umbral de |error| por debajo del cual el derivador toma
+// signo 0 (en punto fijo, cualquier valor distinto de cero)
+template <typename Real> struct Escalar;
+template <> struct Escalar<double> {
+    static string nombre() { return "double"; }
+    static double umbralSigno() { return 1e-10; }
+};
+template <> struct Escalar<float> {
+    static string nombre() { return "float"; }
+    static float umbralSigno() { return 1e-10f; }
+};
+template <int F> struct Escalar<Fijo<F> > {
+    static string nombre() {
+        ostringstream texto;
+        texto << "Q" << 31 - F << "." << F;
+        return texto.str();
+    }
+    static Fijo<F> umbralSigno() { return Fijo<F>::desdeCrudo(1); }
+};
+
+// raiz k-esima de x >= 0 elegida en compilacion: para los ordenes comunes son
+// raices cuadradas/cubicas encadenadas, que son mucho mas baratas que pow()
+template <int K>
+struct Raiz {
+    template <typename Real> static Real calcular(Real x) { return Real(pow((double)x, 1.0 / K)); }
+};
+template <> struct Raiz<1> { template <typename Real> static Real calcular(Real x) { return x; } };
+template <> struct Raiz<2> { template <typename Real> static Real calcular(Real x) { return sqrt(x); } };
+template <> struct Raiz<3> { template <typename Real> static Real calcular(Real x) { return cbrt(x); } };
+template <> struct Raiz<4> { template <typename Real> static Real calcular(Real x) { return sqrt(sqrt(x)); } };
+template <> struct Raiz<6> { template <typename Real> static Real calcular(Real x) { return sqrt(cbrt(x)); } };
+template <> struct Raiz<8> { template <typename Real> static Real calcular(Real x) { return sqrt(sqrt(sqrt(x))); } };
+
+// ganancias por defecto de cada orden. el orden 3 usa las del enunciado; para los
+// demas, las de Levant para la forma no recursiva: la ecuacion de z_i lleva
+// k_i * L^((i+1)/(n+1)) con k = (1.5, 1.1), (2, 2.12, 1.1), (3, 4.16, 3.06, 1.1), ...
+// aca el coeficiente es lambda_i^(n-i) * L^((i+1)/(n+1)), y la ultima ecuacion queda
+// siempre con 1 * L en lugar de 1.1 * L; por eso se toman las de Levant para la
+// constante L/1.1: lambda_i^(n-i) = k_i * 1.1^(-(i+1)/(n+1)). (la secuencia recursiva
+// 1.1, 1.5, 2, 3, 5, 8 no sirve en esta forma: con orden 4 y 5 diverge)
+const int ORDEN_MAXIMO_DERIVADOR = 5;
+
+inline double lambdaPorDefecto(int orden, int i) {
+    static const double levant[ORDEN_MAXIMO_DERIVADOR + 1][ORDEN_MAXIMO_DERIVADOR + 1] = {
+        {1.1},
+        {1.5, 1.1},
+        {2.0, 2.12, 1.1},
+        {3.0, 4.16, 3.06, 1.1},
+        {5.0, 10.03, 9.30, 4.57, 1.1},
+        {7.0, 23.72, 32.24, 20.26, 6.75, 1.1}
+    };
+    static const double enunciado[] = {lambda0, lambda1, lambda2, lambda3};
+    if(orden == 3) return enunciado[i];
+    if(i == orden) return 1.0; // elevado a la 0: no se usa
+    return pow(levant[orden][i] * pow(1.1, -(i + 1.0) / (orden + 1.0)), 1.0 / (orden - i));
+}
+
+// derivador de orden N (la plantilla fija el tamaño de los arreglos y los lazos)
+// los coeficientes -lambda_i^(N-i) * L^((i+1)/(N+1)) y los factores de Taylor
+// tau^k/k! se calculan una sola vez al construirlo (en double, y despues se pasan a
+// Real). en cada muestra hay una sola raiz:
+// r = |error|^(1/(N+1)) y |error|^((N-i)/(N+1)) = r^(N-i) sale multiplicando
+template <int N, typename Real = double>
+struct DerivadorOrden {
+    static const int ORDEN = N;
+    
+    Real z[N + 1];          // z[0] sigue a la señal, z[k] estima la derivada k
+    Real coef[N + 1];
+    Real taylor[N + 1];     // taylor[k] = tau^k / k!
+    
+    DerivadorOrden(double tau = tau_s, double lipschitz = L, const double* lambdas = NULL) {
+        double t = 1.0;
+        for(int i = 0; i <= N; i++) {
+            double lambda = lambdas ? lambdas[i] : lambdaPorDefecto(N, i);
+            coef[i] = Real(-pow(lambda, (double)(N - i)) * pow(lipschitz, (i + 1.0) / (N + 1.0)));
+            if(i > 0) t = t * tau / i;
+            taylor[i] = Real(t);
+        }
+        reset();
+    }
+    
+    // Actualizar estados segun ecuacion (2) del PDF (Taylor hasta el orden N)
+    void actualizar(Real f_ref) {
+        Real error = z[0] - f_ref;
+        Real ae = fabs(error);
         
-        double y_k = b0 * u_k + b1 * u_hist[0] + b2 * u_hist[1] + b3 * u_hist[2]
-                   - a1 * y_hist[0] - a2 * y_hist[1] - a3 * y_hist[2];
+        // potencias |error|^(m/(N+1)) para m = 0..N a partir de una sola raiz
+        Real potencia[N + 1];
+        Real r = Raiz<N + 1>::calcular(ae);
+        potencia[0] = Real(1);
+        for(int m = 1; m <= N; m++) potencia[m] = potencia[m - 1] * r;
+        // evitar division por cero
+        Real signo = (ae < Escalar<Real>::umbralSigno()) ? Real(0) : (error > Real(0) ? Real(1) : Real(-1));
         
-        // Actualizar historicos (desplazar)
-        for(int i = 2; i > 0; i--) {
-            u_hist[i] = u_hist[i-1];
-            y_hist[i] = y_hist[i-1];
+        Real nuevo[N + 1];
+        for(int i = 0; i <= N; i++) {
+            Real phi = coef[i] * potencia[N - i] * signo;
+            Real suma = z[i] + taylor[1] * phi;
+            for(int k = 1; i + k <= N; k++) suma += taylor[k] * z[i + k];
+            nuevo[i] = suma;
         }
-        u_hist[0] = u_k;
-        y_hist[0] = y_k;
-        
+        for(int i = 0; i <= N; i++) z[i] = nuevo[i];
+    }
+    
+    void reset() {
+        for(int i = 0; i <= N; i++) z[i] = Real(0);
+    }
+};
+
+typedef DerivadorOrden<3> Derivador;
+
+
+// PLANTA SISO - G(s) = (7s^2 - 28s + 21) / (s^3 + 9.8s^2 + 30.65s + 30.1)
+
+// DISCRETIZACION DE LA PLANTA
+// la planta se arma al arrancar a partir de G(s): se buscan los polos y ceros, cada uno
+// pasa al plano z con Tustin (s = K (z-1)/(z+1), K = 2/T, o w0/tan(w0 T/2) si se pide
+// prewarp a la frecuencia w0) y se agrupan de a dos en secciones de segundo orden. asi
+// funciona para cualquier tau_s y orden de planta, y la cascada de biquads es mucho mas
+// estable numericamente que el polinomio expandido cuando los polos quedan cerca de z = 1
+// (frecuencias de muestreo altas).
+
+typedef complex<double> Complejo;
+
+// valor de un polinomio (coeficientes de mayor a menor potencia) por Horner
+Complejo evaluarPolinomio(const vector<double>& c, Complejo x) {
+    Complejo valor = 0.0;
+    for(size_t i = 0; i < c.size(); i++) valor = valor * x + c[i];
+    return valor;
+}
+
+// c[0] * prod(x - r_i), para comparar con el polinomio original
+vector<Complejo> polinomioDesdeRaices(double principal, const vector<Complejo>& r) {
+    vector<Complejo> c(1, principal);
+    for(size_t i = 0; i < r.size(); i++) {
+        c.push_back(0.0);
+        for(size_t j = c.size() - 1; j > 0; j--) c[j] -= r[i] * c[j - 1];
+    }
+    return c;
+}
+
+double errorReconstruccion(const vector<double>& c, const vector<Complejo>& r) {
+    vector<Complejo> otro = polinomioDesdeRaices(c[0], r);
+    double error = 0.0, escala = 0.0;
+    for(size_t i = 0; i < c.size(); i++) {
+        error = max(error, abs(otro[i] - c[i]));
+        escala = max(escala, fabs(c[i]));
+    }
+    return error / escala;
+}
+
+// raices de un polinomio (coeficientes de mayor a menor potencia) por Aberth-Ehrlich
+vector<Complejo> raicesPolinomio(const vector<double>& c) {
+    int n = (int)c.size() - 1;
+    vector<Complejo> r(max(n, 0));
+    if(n <= 0) return r;
+    double cota = 0.0; // cota de Cauchy del modulo de las raices
+    for(int i = 1; i <= n; i++) cota = max(cota, fabs(c[i] / c[0]));
+    cota += 1.0;
+    Complejo semilla(0.4, 0.9);
+    for(int i = 0; i < n; i++) r[i] = cota * pow(semilla, i);
+    for(int iteracion = 0; iteracion < 500; iteracion++) {
+        double cambio = 0.0;
+        for(int i = 0; i < n; i++) {
+            Complejo valor = c[0], derivada = 0.0;
+            for(int j = 1; j <= n; j++) {
+                derivada = derivada * r[i] + valor;
+                valor = valor * r[i] + c[j];
+            }
+            if(valor == 0.0) continue;
+            Complejo cociente = valor / derivada, suma = 0.0;
+            for(int j = 0; j < n; j++) if(j != i) suma += 1.0 / (r[i] - r[j]);
+            Complejo paso = cociente / (1.0 - cociente * suma);
+            r[i] -= paso;
+            cambio = max(cambio, abs(paso) / (1.0 + abs(r[i])));
+        }
+        if(cambio < 1e-15) break;
+    }
+    
+    // una raiz de multiplicidad m solo se obtiene con error ~ eps^(1/m): las m copias
+    // quedan desparramadas alrededor. se junta cada racimo, se refina su centro con
+    // Newton sobre la derivada (m-1) del polinomio (donde la raiz es simple) y se usa el
+    // resultado solo si reconstruye mejor el polinomio que las raices sueltas
+    vector<Complejo> agrupadas = r;
+    vector<bool> usada(n, false);
+    for(int i = 0; i < n; i++) {
+        if(usada[i]) continue;
+        vector<int> racimo(1, i);
+        for(int j = i + 1; j < n; j++) {
+            if(!usada[j] && abs(r[j] - r[i]) < 1e-2 * (1.0 + abs(r[i]))) racimo.push_back(j);
+        }
+        for(size_t k = 0; k < racimo.size(); k++) usada[racimo[k]] = true;
+        int m = (int)racimo.size();
+        if(m == 1) continue;
+        Complejo centro = 0.0;
+        for(int k = 0; k < m; k++) centro += r[racimo[k]];
+        centro /= (double)m;
+        vector<double> derivada(c);
+        for(int orden = 0; orden < m - 1; orden++) {
+            int grado = (int)derivada.size() - 1;
+            vector<double> siguiente(grado);
+            for(int k = 0; k < grado; k++) siguiente[k] = derivada[k] * (grado - k);
+            derivada = siguiente;
+        }
+        vector<double> derivada2(derivada.size() - 1);
+        for(size_t k = 0; k + 1 < derivada.size(); k++) derivada2[k] = derivada[k] * (double)(derivada.size() - 1 - k);
+        for(int iteracion = 0; iteracion < 50; iteracion++) {
+            Complejo paso = evaluarPolinomio(derivada, centro) / evaluarPolinomio(derivada2, centro);
+            centro -= paso;
+            if(abs(paso) < 1e-16 * (1.0 + abs(centro))) break;
+        }
+        if(fabs(centro.imag()) < 1e-9 * (1.0 + abs(centro))) centro = centro.real();
+        for(int k = 0; k < m; k++) agrupadas[racimo[k]] = centro;
+    }
+    if(errorReconstruccion(c, agrupadas) < errorReconstruccion(c, r)) r = agrupadas;
+    
+    // las raices reales quedan con una parte imaginaria residual; los pares complejos
+    // se dejan exactamente conjugados para que los coeficientes salgan reales
+    for(int i = 0; i < n; i++) {
+        if(fabs(r[i].imag()) < 1e-9 * (1.0 + abs(r[i]))) r[i] = r[i].real();
+    }
+    vector<bool> emparejada(n, false);
+    for(int i = 0; i < n; i++) {
+        if(r[i].imag() <= 0 || emparejada[i]) continue;
+        int pareja = -1;
+        for(int j = 0; j < n; j++) {
+            if(r[j].imag() < 0 && !emparejada[j] &&
+               (pareja < 0 || abs(r[j] - conj(r[i])) < abs(r[pareja] - conj(r[i])))) pareja = j;
+        }
+        if(pareja >= 0) {
+            Complejo promedio = (r[i] + conj(r[pareja])) / 2.0;
+            r[i] = promedio;
+            r[pareja] = conj(promedio);
+            emparejada[i] = emparejada[pareja] = true;
+        }
+    }
+    // una raiz compleja sin conjugada solo puede ser una real mal resuelta
+    for(int i = 0; i < n; i++) {
+        if(r[i].imag() != 0 && !emparejada[i]) r[i] = r[i].real();
+    }
+    return r;
+}
+
+// agrupa raices en grupos de una o dos: pares conjugados juntos, reales de a dos
+vector<vector<Complejo> > agruparRaices(const vector<Complejo>& raices) {
+    vector<vector<Complejo> > grupos;
+    vector<double> reales;
+    for(size_t i = 0; i < raices.size(); i++) {
+        if(raices[i].imag() > 0) grupos.push_back(vector<Complejo>{raices[i], conj(raices[i])});
+        else if(raices[i].imag() == 0) reales.push_back(raices[i].real());
+    }
+    sort(reales.begin(), reales.end());
+    for(size_t i = 0; i < reales.size(); i += 2) {
+        vector<Complejo> grupo(1, reales[i]);
+        if(i + 1 < reales.size()) grupo.push_back(reales[i + 1]);
+        grupos.push_back(grupo);
+    }
+    return grupos;
+}
+
+// (1 - r1 z^-1)(1 - r2 z^-1) -> c1, c2
+void polinomioSeccion(const vector<Complejo>& grupo, double& c1, double& c2) {
+    c1 = c2 = 0.0;
+    if(grupo.size() >= 1) c1 = -grupo[0].real();
+    if(grupo.size() == 2) {
+        c1 = -(grupo[0] + grupo[1]).real();
+        c2 = (grupo[0] * grupo[1]).real();
+    }
+}
+
+// seccion de segundo orden: H(z) = (b0 + b1 z^-1 + b2 z^-2)/(1 + a1 z^-1 + a2 z^-2)
+// en forma directa II transpuesta (dos estados, sin desplazar historicos). el diseño
+// siempre se hace en double; las secciones de otro tipo se copian redondeando
+template <typename Real>
+struct BiquadDF2T {
+    Real b0, b1, b2, a1, a2;
+    Real s1, s2;
+    
+    BiquadDF2T() : b0(1), b1(0), b2(0), a1(0), a2(0), s1(0), s2(0) {}
+    
+    template <typename Otro>
+    explicit BiquadDF2T(const BiquadDF2T<Otro>& q)
+        : b0((double)q.b0), b1((double)q.b1), b2((double)q.b2), a1((double)q.a1), a2((double)q.a2),
+          s1(0), s2(0) {}
+    
+    Real procesar(Real x) {
+        Real y = b0 * x + s1;
+        s1 = b1 * x - a1 * y + s2;
+        s2 = b2 * x - a2 * y;
+        return y;
+    }
+    
+    // con los coeficientes ya redondeados al tipo Real
+    Complejo respuesta(Complejo z) const {
+        Complejo w = 1.0 / z;
+        return ((double)b0 + w * ((double)b1 + w * (double)b2)) / (1.0 + w * ((double)a1 + w * (double)a2));
+    }
+};
+
+typedef BiquadDF2T<double> SeccionBiquad;
+
+// G(s) -> cascada de biquads por Tustin. devuelve false si G(s) no es propia
+bool discretizarTustin(vector<double> num, vector<double> den, double T, double prewarp,
+                       vector<SeccionBiquad>& secciones) {
+    while(!num.empty() && num[0] == 0.0) num.erase(num.begin());
+    while(!den.empty() && den[0] == 0.0) den.erase(den.begin());
+    if(num.empty() || den.empty() || num.size() > den.size() || T <= 0) return false;
+    
+    double K = (prewarp > 0) ? prewarp / tan(prewarp * T / 2.0) : 2.0 / T;
+    vector<Complejo> ceros = raicesPolinomio(num), polos = raicesPolinomio(den);
+    Complejo ganancia = num[0] / den[0];
+    for(size_t i = 0; i < ceros.size(); i++) {
+        ganancia *= K - ceros[i];
+        ceros[i] = (K + ceros[i]) / (K - ceros[i]);
+    }
+    for(size_t i = 0; i < polos.size(); i++) {
+        ganancia /= K - polos[i];
+        polos[i] = (K + polos[i]) / (K - polos[i]);
+    }
+    // los ceros en infinito de G(s) quedan en z = -1
+    while(ceros.size() < polos.size()) ceros.push_back(-1.0);
+    
+    vector<vector<Complejo> > gruposPolos = agruparRaices(polos), gruposCeros = agruparRaices(ceros);
+    // primero los polos mas cerca del circulo unitario, cada uno con los ceros mas cercanos
+    sort(gruposPolos.begin(), gruposPolos.end(), [](const vector<Complejo>& a, const vector<Complejo>& b) {
+        return abs(a[0]) > abs(b[0]);
+    });
+    secciones.clear();
+    for(size_t i = 0; i < max(gruposPolos.size(), gruposCeros.size()); i++) {
+        SeccionBiquad seccion;
+        if(i < gruposPolos.size()) polinomioSeccion(gruposPolos[i], seccion.a1, seccion.a2);
+        if(!gruposCeros.empty()) {
+            size_t mejor = 0;
+            double distancia = 1e300;
+            for(size_t j = 0; j < gruposCeros.size(); j++) {
+                double d = (i < gruposPolos.size()) ? abs(gruposCeros[j][0] - gruposPolos[i][0]) : 0.0;
+                if(d < distancia) { distancia = d; mejor = j; }
+            }
+            double c1, c2;
+            polinomioSeccion(gruposCeros[mejor], c1, c2);
+            seccion.b1 = c1;
+            seccion.b2 = c2;
+            gruposCeros.erase(gruposCeros.begin() + mejor);
+        }
+        secciones.push_back(seccion);
+    }
+    if(secciones.empty()) secciones.push_back(SeccionBiquad());
+    // toda la ganancia en la primera seccion
+    secciones[0].b0 *= ganancia.real();
+    secciones[0].b1 *= ganancia.real();
+    secciones[0].b2 *= ganancia.real();
+    return true;
+}
+
+// "7s^2 - 28s + 21"
+string textoPolinomio(const vector<double>& c) {
+    ostringstream texto;
+    int grado = (int)c.size() - 1;
+    bool primero = true;
+    for(int i = 0; i <= grado; i++) {
+        double v = c[i];
+        if(v == 0.0) continue;
+        int potencia = grado - i;
+        if(!primero) texto << (v < 0 ? " - " : " + ");
+        else if(v < 0) texto << "-";
+        if(fabs(v) != 1.0 || potencia == 0) texto << fabs(v);
+        if(potencia >= 1) texto << "s";
+        if(potencia >= 2) texto << "^" << potencia;
+        primero = false;
+    }
+    return primero ? "0" : texto.str();
+}
+
+// la planta es una plantilla sobre el tipo de los numeros del lazo (PlantaSISO es la de
+// double); una planta de otro tipo se arma copiando una ya discretizada
+template <typename Real>
+class PlantaGenerica {
+private:
+    vector<double> num, den;              // G(s) continua
+    vector<BiquadDF2T<Real> > secciones;  // G(z) como cascada de biquads
+    
+public:
+    // por defecto la planta del enunciado discretizada con el tau_s actual
+    PlantaGenerica() {
+        definir(vector<double>(numeradorPlanta, numeradorPlanta + 3),
+                vector<double>(denominadorPlanta, denominadorPlanta + 4), tau_s, 0.0);
+    }
+    
+    template <typename Otro>
+    explicit PlantaGenerica(const PlantaGenerica<Otro>& otra)
+        : num(otra.numerador()), den(otra.denominador()) {
+        for(size_t i = 0; i < otra.getSecciones().size(); i++) {
+            secciones.push_back(BiquadDF2T<Real>(otra.getSecciones()[i]));
+        }
+    }
+    
+    // Discretizacion usando transformada bilineal (Tustin) con periodo T
+    // (prewarp en rad/s, 0 = sin prewarp). false si G(s) no es valida
+    bool definir(const vector<double>& num, const vector<double>& den, double T, double prewarp) {
+        vector<SeccionBiquad> nuevas;
+        if(!discretizarTustin(num, den, T, prewarp, nuevas)) return false;
+        this->num = num;
+        this->den = den;
+        secciones.clear();
+        for(size_t i = 0; i < nuevas.size(); i++) secciones.push_back(BiquadDF2T<Real>(nuevas[i]));
+        return true;
+    }
+    
+    // Calcular salida de la planta en el instante k
+    Real actualizar(Real u_k) {
+        Real y_k = u_k;
+        for(size_t i = 0; i < secciones.size(); i++) y_k = secciones[i].procesar(y_k);
         return y_k;
     }
     
     void reset() {
-        y_hist = {0.0, 0.0, 0.0, 0.0};
-        u_hist = {0.0, 0.0, 0.0, 0.0};
+        for(size_t i = 0; i < secciones.size(); i++) secciones[i].s1 = secciones[i].s2 = Real(0);
+    }
+    
+    const vector<BiquadDF2T<Real> >& getSecciones() const { return secciones; }
+    const vector<double>& numerador() const { return num; }
+    const vector<double>& denominador() const { return den; }
+    
+    string descripcion() const {
+        return "G(s) = (" + textoPolinomio(num) + ")/(" + textoPolinomio(den) + ")";
+    }
+    
+    // G(s) en s = jw y G(z) en z = e^(jwT), para verificar la discretizacion
+    Complejo respuestaContinua(Complejo s) const {
+        Complejo n = 0.0, d = 0.0;
+        for(size_t i = 0; i < num.size(); i++) n = n * s + num[i];
+        for(size_t i = 0; i < den.size(); i++) d = d * s + den[i];
+        return n / d;
+    }
+    
+    Complejo respuestaDiscreta(Complejo z) const {
+        Complejo h = 1.0;
+        for(size_t i = 0; i < secciones.size(); i++) h *= secciones[i].respuesta(z);
+        return h;
     }
 };
 
+typedef PlantaGenerica<double> PlantaSISO;
+
 
 // GENERADOR DE SEÑALES DE REFERENCIA
 
@@ -171,6 +651,23 @@ public:
         }
     }
     
+    // derivada n-esima exacta de la referencia (para medir el error del derivador);
+    // el escalon se toma como constante a cada lado del salto
+    static double derivada(TipoSenal tipo, double t, int n) {
+        switch(tipo) {
+            case RAMPA:
+                return (n == 1 && t >= 1.0) ? 0.5 : 0.0;
+                
+            case SENOIDAL: {
+                double w = 2.0 * M_PI * 0.5;
+                return pow(w, n) * sin(w * t + n * M_PI / 2.0);
+            }
+            
+            default:
+                return 0.0;
+        }
+    }
+    
     static string getNombre(TipoSenal tipo) {
         switch(tipo) {
             case ESCALON: return "Escalon";
@@ -182,24 +679,593 @@ public:
 };
 
 
+// ESCRITOR DE TRAZAS
+// escribir cada muestra con << ... << endl formatea siete doubles y vacia el archivo en
+// cada fila; en simulaciones largas eso es lo que mas tarda. el escritor junta las filas
+// en un buffer de 1 MB y lo escribe de a bloques. ademas del CSV de siempre tiene un
+// formato binario mas compacto (opcionalmente en float) y se puede guardar solo una de
+// cada N muestras.
+//
+// formato binario (con el orden de bytes de la maquina):
+//   "HILT" | version u32 | columnas u32 | bytes por valor u32 (4 u 8) | decimacion u32 |
+//   tau_s double | nombres de las columnas terminados en '\0' | filas de valores
+
+struct OpcionesTraza {
+    bool binario;
+    bool float32;   // solo para el binario
+    int decimacion; // se guarda una de cada 'decimacion' muestras
+    int capacidadAnillo; // filas en camino entre el lazo de control y el registrador
+    bool guardar;   // false = solo las medidas, sin archivo de resultados
+    
+    OpcionesTraza() : binario(false), float32(false), decimacion(1), capacidadAnillo(4096), guardar(true) {}
+};
+
+class EscritorTraza {
+private:
+    static const size_t TAM_BUFFER = 1 << 20;
+    
+    ofstream archivo;
+    OpcionesTraza opciones;
+    size_t columnas;
+    vector<char> buffer;
+    size_t usado;
+    long long recibidas;
+    long long escritas;
+    
+    void vaciar() {
+        if(usado > 0) archivo.write(&buffer[0], usado);
+        usado = 0;
+    }
+    
+    void agregar(const void* datos, size_t bytes) {
+        if(usado + bytes > buffer.size()) vaciar();
+        if(bytes > buffer.size()) { archivo.write((const char*)datos, bytes); return; }
+        memcpy(&buffer[usado], datos, bytes);
+        usado += bytes;
+    }
+    
+public:
+    EscritorTraza(const string& ruta, const vector<string>& nombres, const OpcionesTraza& op, double tau)
+        : archivo(ruta.c_str(), ios::binary), opciones(op), columnas(nombres.size()),
+          buffer(TAM_BUFFER), usado(0), recibidas(0), escritas(0) {
+        if(opciones.decimacion < 1) opciones.decimacion = 1;
+        if(opciones.binario) {
+            uint32_t cabecera[4] = {1, (uint32_t)columnas, opciones.float32 ? 4u : 8u,
+                                    (uint32_t)opciones.decimacion};
+            agregar("HILT", 4);
+            agregar(cabecera, sizeof(cabecera));
+            agregar(&tau, sizeof(tau));
+            for(size_t i = 0; i < columnas; i++) agregar(nombres[i].c_str(), nombres[i].size() + 1);
+        } else {
+            string linea;
+            for(size_t i = 0; i < columnas; i++) linea += (i ? "," : "") + nombres[i];
+            linea += '\n';
+            agregar(linea.data(), linea.size());
+        }
+    }
+    
+    ~EscritorTraza() { cerrar(); }
+    
+    bool abierto() const { return archivo.is_open(); }
+    long long filasEscritas() const { return escritas; }
+    
+    // fila = un valor por columna
+    void escribir(const double* fila) {
+        if(recibidas++ % opciones.decimacion != 0) return;
+        escritas++;
+        if(!opciones.binario) {
+            // mismo texto que fixed << setprecision(6)
+            char texto[512];
+            for(size_t i = 0; i < columnas; i++) {
+                int n = snprintf(texto, sizeof(texto), i + 1 < columnas ? "%.6f," : "%.6f\n", fila[i]);
+                agregar(texto, (size_t)n);
+            }
+        } else if(opciones.float32) {
+            for(size_t i = 0; i < columnas; i++) {
+                float valor = (float)fila[i];
+                agregar(&valor, sizeof(valor));
+            }
+        } else {
+            agregar(fila, columnas * sizeof(double));
+        }
+    }
+    
+    void cerrar() {
+        if(!archivo.is_open()) return;
+        vaciar();
+        archivo.close();
+    }
+};
+
+// pasa una traza binaria al CSV de siempre (el que lee el script de Python)
+bool convertirTraza(const string& entrada, const string& salida) {
+    ifstream archivo(entrada.c_str(), ios::binary);
+    char magico[4];
+    uint32_t cabecera[4];
+    double tau;
+    if(!archivo.read(magico, 4) || memcmp(magico, "HILT", 4) != 0 ||
+       !archivo.read((char*)cabecera, sizeof(cabecera)) || !archivo.read((char*)&tau, sizeof(tau)) ||
+       cabecera[0] != 1 || (cabecera[2] != 4 && cabecera[2] != 8) || cabecera[1] == 0) {
+        cerr << "Error: " << entrada << " no es una traza binaria valida" << endl;
+        return false;
+    }
+    size_t columnas = cabecera[1];
+    vector<string> nombres(columnas);
+    for(size_t i = 0; i < columnas; i++) getline(archivo, nombres[i], '\0');
+    
+    EscritorTraza csv(salida, nombres, OpcionesTraza(), tau);
+    if(!csv.abierto()) {
+        cerr << "Error: no se pudo crear " << salida << endl;
+        return false;
+    }
+    vector<char> crudo(columnas * cabecera[2]);
+    vector<double> fila(columnas);
+    while(archivo.read(&crudo[0], crudo.size())) {
+        for(size_t i = 0; i < columnas; i++) {
+            if(cabecera[2] == 8) memcpy(&fila[i], &crudo[i * 8], 8);
+            else { float valor; memcpy(&valor, &crudo[i * 4], 4); fila[i] = valor; }
+        }
+        csv.escribir(&fila[0]);
+    }
+    csv.cerrar();
+    cout << "Convertidas " << csv.filasEscritas() << " filas (Ts = " << tau * cabecera[3]
+         << " s) a " << salida << endl;
+    return true;
+}
+
+
+// ANILLO ENTRE EL LAZO DE CONTROL Y EL REGISTRADOR
+// el lazo de control no escribe archivos ni pantalla: deja cada fila en este anillo y un
+// hilo registrador la saca y la pasa al escritor de trazas y al progreso. hay un solo
+// productor y un solo consumidor, asi que alcanza con dos indices atomicos (cada uno lo
+// escribe un solo hilo) y ninguna operacion espera al otro hilo. cada lado guarda una
+// copia del indice del otro para no leer la linea de cache compartida en cada fila.
+
+template <typename T>
+class AnilloSPSC {
+private:
+    vector<T> datos;
+    size_t mascara;
+    alignas(64) atomic<size_t> escritura; // solo lo modifica el productor
+    size_t lecturaVista;                  // copia del productor
+    alignas(64) atomic<size_t> lectura;   // solo lo modifica el consumidor
+    size_t escrituraVista;                // copia del consumidor
+    
+public:
+    // la capacidad se redondea a potencia de 2
+    explicit AnilloSPSC(size_t capacidad) : escritura(0), lecturaVista(0), lectura(0), escrituraVista(0) {
+        size_t tam = 2;
+        while(tam < capacidad) tam <<= 1;
+        datos.resize(tam);
+        mascara = tam - 1;
+    }
+    
+    size_t capacidad() const { return datos.size(); }
+    
+    // productor; false si esta lleno
+    bool poner(const T& valor) {
+        size_t e = escritura.load(memory_order_relaxed);
+        if(e - lecturaVista == datos.size()) {
+            lecturaVista = lectura.load(memory_order_acquire);
+            if(e - lecturaVista == datos.size()) return false;
+        }
+        datos[e & mascara] = valor;
+        escritura.store(e + 1, memory_order_release);
+        return true;
+    }
+    
+    // filas que el productor todavia no sabe que se consumieron (cota de la ocupacion)
+    size_t ocupacionVista() const { return escritura.load(memory_order_relaxed) - lecturaVista; }
+    
+    // consumidor; false si esta vacio
+    bool sacar(T& valor) {
+        size_t l = lectura.load(memory_order_relaxed);
+        if(l == escrituraVista) {
+            escrituraVista = escritura.load(memory_order_acquire);
+            if(l == escrituraVista) return false;
+        }
+        valor = datos[l & mascara];
+        lectura.store(l + 1, memory_order_release);
+        return true;
+    }
+};
+
+
+// MODO TIEMPO REAL
+// sin opciones el lazo corre lo mas rapido posible. con --tiempo-real cada muestra espera
+// su plazo absoluto (inicio + k * tau_s) con clock_nanosleep(TIMER_ABSTIME), asi los
+// errores de un ciclo no se acumulan en los siguientes. el lazo de control corre en su
+// propio hilo (opcionalmente SCHED_FIFO y fijo a un nucleo) y no hace ninguna E/S: deja
+// cada fila en el anillo hacia el registrador.
+
+struct OpcionesTiempoReal {
+    bool activo;
+    int prioridad;        // SCHED_FIFO si > 0
+    int cpu;              // nucleo fijo si >= 0
+    bool bloquearMemoria; // mlockall
+    int cpuPlanta;        // nucleo del proceso de la planta en --planta-proceso (-1 = el siguiente a cpu)
+    
+    OpcionesTiempoReal() : activo(false), prioridad(0), cpu(-1), bloquearMemoria(false), cpuPlanta(-1) {}
+};
+
+inline long long ahoraNs() {
+#ifdef __linux__
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// 0 si llego al plazo; si no, el codigo de error de clock_nanosleep (solo EINTR se
+// reintenta: con cualquier otro el hilo de control giraria para siempre)
+inline int dormirHasta(long long plazoNs) {
+#ifdef __linux__
+    timespec ts;
+    ts.tv_sec = plazoNs / 1000000000LL;
+    ts.tv_nsec = plazoNs % 1000000000LL;
+    int resultado;
+    while((resultado = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) == EINTR) {}
+    return resultado;
+#else
+    this_thread::sleep_until(chrono::steady_clock::time_point(chrono::nanoseconds(plazoNs)));
+    return 0;
+#endif
+}
+
+// se llama desde el hilo de control; devuelve los avisos (sin permisos, etc.)
+string configurarHiloTiempoReal(const OpcionesTiempoReal& opciones) {
+    string avisos;
+#ifdef __linux__
+    if(opciones.prioridad > 0) {
+        sched_param parametro;
+        parametro.sched_priority = opciones.prioridad;
+        if(pthread_setschedparam(pthread_self(), SCHED_FIFO, &parametro) != 0)
+            avisos += "no se pudo usar SCHED_FIFO (hacen falta permisos de tiempo real); ";
+    }
+    if(opciones.cpu >= 0) {
+        cpu_set_t nucleos;
+        CPU_ZERO(&nucleos);
+        CPU_SET(opciones.cpu, &nucleos);
+        if(pthread_setaffinity_np(pthread_self(), sizeof(nucleos), &nucleos) != 0)
+            avisos += "no se pudo fijar el hilo al nucleo pedido; ";
+    }
+#else
+    if(opciones.prioridad > 0 || opciones.cpu >= 0)
+        avisos += "SCHED_FIFO y afinidad solo estan disponibles en Linux; ";
+#endif
+    return avisos;
+}
+
+// latencia de despertar (cuanto despues del plazo arranca el ciclo), tiempo de calculo
+// y plazos perdidos (el ciclo termino despues del plazo siguiente)
+struct EstadisticasTiempoReal {
+    static const int CUBETAS = 13;
+    
+    long long ciclos, perdidos;
+    long long latenciaMax, calculoMax;
+    double sumaLatencia, sumaLatencia2, sumaCalculo;
+    long long histograma[CUBETAS];
+    
+    EstadisticasTiempoReal() : ciclos(0), perdidos(0), latenciaMax(0), calculoMax(0),
+                               sumaLatencia(0), sumaLatencia2(0), sumaCalculo(0) {
+        for(int i = 0; i < CUBETAS; i++) histograma[i] = 0;
+    }
+    
+    // limite superior de cada cubeta en microsegundos (la ultima no tiene limite)
+    static long long limiteUs(int cubeta) {
+        static const long long limites[CUBETAS - 1] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 4000};
+        return limites[cubeta];
+    }
+    
+    void registrar(long long latenciaNs, long long calculoNs, bool perdido) {
+        if(latenciaNs < 0) latenciaNs = 0;
+        ciclos++;
+        if(perdido) perdidos++;
+        latenciaMax = max(latenciaMax, latenciaNs);
+        calculoMax = max(calculoMax, calculoNs);
+        sumaLatencia += latenciaNs;
+        sumaLatencia2 += (double)latenciaNs * latenciaNs;
+        sumaCalculo += calculoNs;
+        int cubeta = 0;
+        while(cubeta < CUBETAS - 1 && latenciaNs >= limiteUs(cubeta) * 1000) cubeta++;
+        histograma[cubeta]++;
+    }
+    
+    void mostrar() const {
+        if(ciclos == 0) return;
+        double media = sumaLatencia / ciclos;
+        double desviacion = sqrt(max(0.0, sumaLatencia2 / ciclos - media * media));
+        cout << "\n=== ESTADISTICAS DE TIEMPO REAL ===" << endl;
+        cout << fixed << setprecision(1);
+        cout << "Ciclos: " << ciclos << " (periodo " << tau_s * 1e6 << " us)" << endl;
+        cout << "Latencia de despertar: media " << media / 1000 << " us, max " << latenciaMax / 1000.0
+             << " us, jitter (desviacion) " << desviacion / 1000 << " us" << endl;
+        cout << "Calculo por ciclo: media " << sumaCalculo / ciclos / 1000 << " us, max "
+             << calculoMax / 1000.0 << " us" << endl;
+        cout << "Plazos perdidos: " << perdidos << endl;
+        cout << "Histograma de latencia:" << endl;
+        long long mayor = *max_element(histograma, histograma + CUBETAS);
+        for(int i = 0; i < CUBETAS; i++) {
+            if(i < CUBETAS - 1) cout << "  < " << setw(5) << limiteUs(i) << " us: ";
+            else cout << "  >= " << setw(4) << limiteUs(i - 1) << " us: ";
+            cout << setw(7) << histograma[i] << " " << string((size_t)(40 * histograma[i] / mayor), '#') << endl;
+        }
+        cout << defaultfloat;
+    }
+};
+
+
 // SIMULADOR HIL PRINCIPAL
+// el orden del derivador es un parametro de plantilla (3 = el del enunciado)
+
+// medidas de una corrida, acumuladas muestra a muestra dentro del lazo (memoria
+// constante, no hace falta guardar la traza para calcularlas despues)
+struct ResumenSimulacion {
+    static const int ORDEN_MAXIMO = 5;
+    
+    long long muestras;
+    double sumaErr, sumaErrY;
+    double maxSeguimiento; // maximo |z0 - referencia| despues del primer segundo
+    long long filasEscritas, filasDescartadas;
+    double segundos;       // tiempo de reloj de la corrida
+    
+    // error de z_i contra la derivada i-esima exacta de la referencia
+    int orden;
+    double sumaErrDerivada[ORDEN_MAXIMO + 1], maxErrDerivada[ORDEN_MAXIMO + 1];
+    
+    // respuesta de la planta al escalon (solo con la señal escalon)
+    bool escalon;
+    double inicioEscalon, valorFinal; // valorFinal = G(0) * amplitud
+    double cruce10, cruce90;          // primer instante en que y pasa el 10% y el 90% (-1 = nunca)
+    double ultimoFueraBanda;          // ultimo instante con |y - final| > 2% (-1 = nunca)
+    double pico;                      // maximo de y en la direccion del valor final
+    double ultimoInstante;
+    
+    ResumenSimulacion() : muestras(0), sumaErr(0), sumaErrY(0), maxSeguimiento(0),
+                          filasEscritas(0), filasDescartadas(0), segundos(0), orden(0),
+                          escalon(false), inicioEscalon(0), valorFinal(0), cruce10(-1), cruce90(-1),
+                          ultimoFueraBanda(-1), pico(-1e300), ultimoInstante(0) {
+        for(int i = 0; i <= ORDEN_MAXIMO; i++) sumaErrDerivada[i] = maxErrDerivada[i] = 0.0;
+    }
+    
+    void prepararEscalon(double inicio, double final) {
+        escalon = true;
+        inicioEscalon = inicio;
+        valorFinal = final;
+    }
+    
+    // z[1..n] contra exactas[1..n]
+    void acumularDerivadas(const double* z, const double* exactas, int n) {
+        orden = min(n, (int)ORDEN_MAXIMO);
+        for(int i = 1; i <= orden; i++) {
+            double err = z[i] - exactas[i];
+            sumaErrDerivada[i] += err * err;
+            maxErrDerivada[i] = max(maxErrDerivada[i], fabs(err));
+        }
+    }
+    
+    void acumularRespuesta(double t, double y) {
+        ultimoInstante = t;
+        if(!escalon || t < inicioEscalon) return;
+        double signo = (valorFinal < 0) ? -1.0 : 1.0;
+        double avance = signo * y; // y medido en la direccion del valor final
+        double final = fabs(valorFinal);
+        if(cruce10 < 0 && avance >= 0.1 * final) cruce10 = t;
+        if(cruce90 < 0 && avance >= 0.9 * final) cruce90 = t;
+        if(fabs(y - valorFinal) > 0.02 * final) ultimoFueraBanda = t;
+        pico = max(pico, avance);
+    }
+    
+    void acumular(double t, double ref, double y, double z0) {
+        double err = z0 - ref;
+        double errY = y - ref;
+        muestras++;
+        sumaErr += err * err;
+        sumaErrY += errY * errY;
+        if(t >= 1.0) maxSeguimiento = max(maxSeguimiento, fabs(err));
+    }
+    
+    double rmsSeguimiento() const { return muestras ? sqrt(sumaErr / muestras) : 0.0; }
+    double rmsPlanta() const { return muestras ? sqrt(sumaErrY / muestras) : 0.0; }
+    double rmsDerivada(int i) const { return muestras ? sqrt(sumaErrDerivada[i] / muestras) : 0.0; }
+    
+    // -1 si no corresponde (no es escalon) o no llego a pasar
+    double tiempoSubida() const { return (cruce10 >= 0 && cruce90 >= 0) ? cruce90 - cruce10 : -1.0; }
+    double tiempoEstablecimiento() const {
+        if(!escalon || muestras == 0 || ultimoFueraBanda >= ultimoInstante) return -1.0;
+        return max(0.0, ultimoFueraBanda - inicioEscalon);
+    }
+    double sobrepaso() const { // en %
+        if(!escalon || valorFinal == 0 || pico < -1e299) return -1.0;
+        return max(0.0, (pico - fabs(valorFinal)) / fabs(valorFinal) * 100.0);
+    }
+};
+
+void imprimirResumen(ostream& out, const ResumenSimulacion& r) {
+    out << "\n--- Medidas de la corrida ---" << endl;
+    out << setprecision(6);
+    out << "Seguimiento z0:     RMS " << r.rmsSeguimiento() << ", maximo " << r.maxSeguimiento << " (despues de t=1s)" << endl;
+    for(int i = 1; i <= r.orden; i++) {
+        out << "Derivada z" << i << ":        RMS " << r.rmsDerivada(i) << ", maximo " << r.maxErrDerivada[i]
+            << " (contra la derivada exacta)" << endl;
+    }
+    out << "Planta (y - ref):   RMS " << r.rmsPlanta() << endl;
+    if(r.escalon) {
+        out << "Escalon de la planta (valor final " << r.valorFinal << "):" << endl;
+        if(r.tiempoSubida() >= 0) out << "  tiempo de subida (10-90%): " << r.tiempoSubida() << " s" << endl;
+        else out << "  tiempo de subida (10-90%): no llego al 90%" << endl;
+        if(r.tiempoEstablecimiento() >= 0) out << "  tiempo de establecimiento (2%): " << r.tiempoEstablecimiento() << " s" << endl;
+        else out << "  tiempo de establecimiento (2%): no se establecio" << endl;
+        out << "  sobrepaso: " << r.sobrepaso() << " %" << endl;
+    }
+}
+
+// -1 (no corresponde) se escribe como null
+void escribirNumeroJSON(ostream& out, double v) {
+    if(v < 0 || !std::isfinite(v)) out << "null";
+    else out << v;
+}
+
+void escribirResumenJSON(ostream& out, const ResumenSimulacion& r) {
+    streamsize precision = out.precision(9);
+    out << "{\"muestras\": " << r.muestras
+        << ", \"rms_seguimiento\": " << r.rmsSeguimiento()
+        << ", \"max_seguimiento\": " << r.maxSeguimiento
+        << ", \"rms_planta\": " << r.rmsPlanta()
+        << ", \"rms_derivadas\": [";
+    for(int i = 1; i <= r.orden; i++) out << (i > 1 ? ", " : "") << r.rmsDerivada(i);
+    out << "], \"max_derivadas\": [";
+    for(int i = 1; i <= r.orden; i++) out << (i > 1 ? ", " : "") << r.maxErrDerivada[i];
+    out << "], \"tiempo_subida\": ";
+    escribirNumeroJSON(out, r.tiempoSubida());
+    out << ", \"tiempo_establecimiento\": ";
+    escribirNumeroJSON(out, r.tiempoEstablecimiento());
+    out << ", \"sobrepaso\": ";
+    escribirNumeroJSON(out, r.sobrepaso());
+    out << ", \"filas_escritas\": " << r.filasEscritas
+        << ", \"filas_descartadas\": " << r.filasDescartadas
+        << ", \"segundos\": " << r.segundos << "}";
+    out.precision(precision);
+}
 
+template <int N = 3>
 class SimuladorHIL {
 private:
     PlantaSISO planta;
-    Derivador derivador;
+    DerivadorOrden<N> derivador;
     GeneradorSenal::TipoSenal tipoSenal;
     double tiempo_simulacion;
+    OpcionesTraza traza;
+    OpcionesTiempoReal tiempoReal;
+    string archivoSalida; // vacio = resultados_hil_<senal>
+    string archivoJSON;   // medidas en JSON ("-" = salida estandar)
+    bool silencioso;      // sin mensajes (para correr varias simulaciones a la vez)
+    ResumenSimulacion resumen;
+    
+    // acumula las medidas del resumen con una fila (t, ref, y, z0, ...)
+    void acumular(const double* fila) {
+        double exactas[N + 1];
+        for(int i = 1; i <= N; i++) exactas[i] = GeneradorSenal::derivada(tipoSenal, fila[0], i);
+        resumen.acumular(fila[0], fila[1], fila[2], fila[3]);
+        resumen.acumularDerivadas(fila + 3, exactas, N);
+        resumen.acumularRespuesta(fila[0], fila[2]);
+    }
+    
+    // un ciclo del lazo de control; deja en 'fila' t, ref, y, z0..zN
+    void paso(double t, double* fila) {
+        // 1. Generar señal de referencia
+        double ref = GeneradorSenal::generar(tipoSenal, t);
+        
+        // 2. Actualizar derivador (recibe referencia)
+        derivador.actualizar(ref);
+        
+        // 3. Calcular salida de la planta (recibe z0 del derivador)
+        double y_planta = planta.actualizar(derivador.z[0]);
+        
+        fila[0] = t;
+        fila[1] = ref;
+        fila[2] = y_planta;
+        for(int i = 0; i <= N; i++) fila[3 + i] = derivador.z[i];
+    }
+    
+    static void mostrarProgreso(const double* fila) {
+        cout << "t=" << setw(6) << setprecision(2) << fila[0] 
+             << "s | Ref=" << setw(7) << setprecision(3) << fila[1]
+             << " | Y_planta=" << setw(7) << setprecision(3) << fila[2]
+             << " | z0=" << setw(7) << setprecision(3) << fila[3]
+             << endl;
+    }
+    
+    struct Registro {
+        int k;
+        double fila[N + 4];
+    };
+    
+    // contadores del lado productor del anillo
+    struct EstadoRegistro {
+        long long descartadas; // con --tiempo-real el lazo no espera: si el anillo esta lleno la fila se pierde
+        long long esperas;     // sin --tiempo-real el lazo espera a que el registrador libere lugar
+        size_t ocupacionMax;
+        
+        EstadoRegistro() : descartadas(0), esperas(0), ocupacionMax(0) {}
+    };
+    
+    void publicar(AnilloSPSC<Registro>& anillo, const Registro& registro, bool puedeEsperar, EstadoRegistro& estado) {
+        if(!anillo.poner(registro)) {
+            if(!puedeEsperar) { estado.descartadas++; return; }
+            estado.esperas++;
+            while(!anillo.poner(registro)) this_thread::yield();
+        }
+        estado.ocupacionMax = max(estado.ocupacionMax, anillo.ocupacionVista());
+    }
+    
+    // lazo a 250 Hz con plazos absolutos, en un hilo propio. no escribe en pantalla
+    // (el registrador la esta usando): los avisos y estadisticas se muestran despues
+    void lazoConPlazos(int num_muestras, AnilloSPSC<Registro>& anillo, EstadoRegistro& estado,
+                       EstadisticasTiempoReal& estadisticas, string& avisos) {
+#ifdef __linux__
+        if(tiempoReal.bloquearMemoria && mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+            avisos += "no se pudo bloquear la memoria (mlockall); ";
+#endif
+        thread control([&]() {
+            avisos += configurarHiloTiempoReal(tiempoReal);
+            const long long periodo = (long long)llround(tau_s * 1e9);
+            const long long inicio = ahoraNs() + periodo;
+            double t = 0.0;
+            Registro registro;
+            for(int k = 0; k < num_muestras; k++) {
+                long long plazo = inicio + k * periodo;
+                int error = dormirHasta(plazo);
+                if(error != 0) {
+                    avisos += string("clock_nanosleep fallo (") + strerror(error) + "), el lazo se corto en la muestra "
+                              + to_string(k) + "; ";
+                    break;
+                }
+                long long despierto = ahoraNs();
+                registro.k = k;
+                paso(t, registro.fila);
+                acumular(registro.fila);
+                publicar(anillo, registro, false, estado);
+                long long fin = ahoraNs();
+                estadisticas.registrar(despierto - plazo, fin - despierto, fin > plazo + periodo);
+                t += tau_s;
+            }
+        });
+        control.join();
+    }
     
 public:
-    SimuladorHIL() : tiempo_simulacion(10.0) {}
+    SimuladorHIL(const OpcionesTraza& opcionesTraza = OpcionesTraza(),
+                 const OpcionesTiempoReal& opcionesTiempoReal = OpcionesTiempoReal(),
+                 const PlantaSISO& plantaSISO = PlantaSISO())
+        : planta(plantaSISO), tipoSenal(GeneradorSenal::ESCALON), tiempo_simulacion(10.0),
+          traza(opcionesTraza), tiempoReal(opcionesTiempoReal), silencioso(false) {}
+    
+    // configuracion sin preguntar (modo escenarios)
+    void configurar(GeneradorSenal::TipoSenal tipo, double tiempo, const string& salida) {
+        tipoSenal = tipo;
+        tiempo_simulacion = tiempo;
+        archivoSalida = salida;
+        silencioso = true;
+    }
+    
+    void setGanancias(double lipschitz, const double* lambdas) {
+        derivador = DerivadorOrden<N>(tau_s, lipschitz, lambdas);
+    }
+    
+    void setJSON(const string& ruta) { archivoJSON = ruta; }
+    
+    const ResumenSimulacion& getResumen() const { return resumen; }
     
     void configurar() {
         cout << "=====================================================" << endl;
         cout << "   SIMULADOR HIL: PLANTA SISO + DERIVADOR" << endl;
         cout << "=====================================================" << endl;
-        cout << "\nPlanta: G(s) = (7s^2 - 28s + 21)/(s^3 + 9.8s^2 + 30.65s + 30.1)" << endl;
-        cout << "Frecuencia de muestreo: 250 Hz (Ts = 0.004 s)" << endl;
+        cout << "\nPlanta: " << planta.descripcion() << endl;
+        cout << "Frecuencia de muestreo: " << 1.0 / tau_s << " Hz (Ts = " << tau_s << " s)" << endl;
         
         cout << "\n--- Seleccione el tipo de señal de referencia ---" << endl;
         cout << "1. Escalon unitario (inicio en t=1s)" << endl;
@@ -226,76 +1292,142 @@ public:
         }
     }
     
-    void ejecutar() {
+    // false si no se pudo crear el archivo de salida
+    bool ejecutar() {
         // Resetear sistemas
         planta.reset();
         derivador.reset();
+        resumen = ResumenSimulacion();
+        if(tipoSenal == GeneradorSenal::ESCALON) resumen.prepararEscalon(1.0, planta.respuestaDiscreta(1.0).real());
+        chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
         
         // Crear archivo de salida
-        string nombreArchivo = "resultados_hil_" + 
-                              GeneradorSenal::getNombre(tipoSenal) + ".txt";
-        ofstream archivo(nombreArchivo);
+        string nombreArchivo = !archivoSalida.empty() ? archivoSalida : "resultados_hil_" + 
+                              GeneradorSenal::getNombre(tipoSenal) + (traza.binario ? ".bin" : ".txt");
         
         // Encabezado del archivo CSV
-        archivo << "Tiempo,Referencia,Salida_Planta,z0_Seguimiento,z1_Derivada1,z2_Derivada2,z3_Derivada3" << endl;
-        archivo << fixed << setprecision(6);
-        
-        cout << "\n=====================================================" << endl;
-        cout << "   INICIANDO SIMULACION EN TIEMPO REAL" << endl;
-        cout << "=====================================================" << endl;
-        cout << "Señal: " << GeneradorSenal::getNombre(tipoSenal) << endl;
-        cout << "Tiempo total: " << tiempo_simulacion << " segundos" << endl;
-        cout << "Guardando en: " << nombreArchivo << endl;
-        cout << "----------------------------------------------------" << endl;
+        vector<string> columnas;
+        columnas.push_back("Tiempo");
+        columnas.push_back("Referencia");
+        columnas.push_back("Salida_Planta");
+        columnas.push_back("z0_Seguimiento");
+        for(int i = 1; i <= N; i++) {
+            ostringstream nombre;
+            nombre << "z" << i << "_Derivada" << i;
+            columnas.push_back(nombre.str());
+        }
+        unique_ptr<EscritorTraza> archivo;
+        if(traza.guardar) {
+            archivo.reset(new EscritorTraza(nombreArchivo, columnas, traza, tau_s));
+            if(!archivo->abierto()) {
+                if(!silencioso) cout << "Error: no se pudo crear " << nombreArchivo << endl;
+                return false;
+            }
+        }
+        
+        if(!silencioso) {
+            cout << "\n=====================================================" << endl;
+            cout << "   INICIANDO SIMULACION EN TIEMPO REAL" << endl;
+            cout << "=====================================================" << endl;
+            cout << "Señal: " << GeneradorSenal::getNombre(tipoSenal) << endl;
+            cout << "Tiempo total: " << tiempo_simulacion << " segundos" << endl;
+            cout << "Guardando en: " << (archivo ? nombreArchivo : "(sin archivo, solo medidas)") << endl;
+            if(tiempoReal.activo) cout << "Modo: tiempo real (una muestra cada " << tau_s * 1000 << " ms)" << endl;
+            else cout << "Modo: lo mas rapido posible (--tiempo-real para " << 1.0 / tau_s << " Hz reales)" << endl;
+            cout << "----------------------------------------------------" << endl;
+        }
         
         int num_muestras = (int)(tiempo_simulacion / tau_s);
+        int cadaProgreso = max(1, (int)llround(0.5 / tau_s));
         double t = 0.0;
         
+        // 4. y 5. el registrador guarda las filas en el archivo y muestra el progreso
+        // cada 0.5 segundos, fuera del lazo de control
+        AnilloSPSC<Registro> anillo(max(traza.capacidadAnillo, 2));
+        EstadoRegistro estado;
+        atomic<bool> terminado(false);
+        thread registrador([&]() {
+            Registro registro;
+            for(;;) {
+                // si el lazo ya habia terminado y el anillo esta vacio, no queda nada por llegar
+                bool fin = terminado.load(memory_order_acquire);
+                if(anillo.sacar(registro)) {
+                    if(archivo) archivo->escribir(registro.fila);
+                    if(!silencioso && (registro.k % cadaProgreso == 0 || registro.k == num_muestras - 1))
+                        mostrarProgreso(registro.fila);
+                } else if(fin) {
+                    break;
+                } else {
+                    this_thread::sleep_for(chrono::milliseconds(1));
+                }
+            }
+        });
+        
         // Simulacion principal
-        for(int k = 0; k < num_muestras; k++) {
-            // 1. Generar señal de referencia
-            double ref = GeneradorSenal::generar(tipoSenal, t);
-            
-            // 2. Actualizar derivador (recibe referencia)
-            derivador.actualizar(ref);
-            
-            // 3. Calcular salida de la planta (recibe z0 del derivador)
-            double y_planta = planta.actualizar(derivador.z0);
-            
-            // 4. Guardar datos en archivo
-            archivo << t << "," 
-                    << ref << "," 
-                    << y_planta << ","
-                    << derivador.z0 << "," 
-                    << derivador.z1 << "," 
-                    << derivador.z2 << "," 
-                    << derivador.z3 << endl;
-            
-            // 5. Mostrar progreso cada 0.5 segundos
-            if(k % 125 == 0 || k == num_muestras - 1) {
-                cout << "t=" << setw(6) << setprecision(2) << t 
-                     << "s | Ref=" << setw(7) << setprecision(3) << ref
-                     << " | Y_planta=" << setw(7) << setprecision(3) << y_planta
-                     << " | z0=" << setw(7) << setprecision(3) << derivador.z0
-                     << endl;
+        EstadisticasTiempoReal estadisticas;
+        string avisos;
+        if(tiempoReal.activo) {
+            lazoConPlazos(num_muestras, anillo, estado, estadisticas, avisos);
+        } else {
+            Registro registro;
+            for(int k = 0; k < num_muestras; k++) {
+                // 1. a 3. referencia, derivador y planta
+                registro.k = k;
+                paso(t, registro.fila);
+                acumular(registro.fila);
+                publicar(anillo, registro, true, estado);
+                
+                // 6. Incrementar tiempo
+                t += tau_s;
             }
-            
-            // 6. Incrementar tiempo
-            t += tau_s;
         }
+        terminado.store(true, memory_order_release);
+        registrador.join();
         
-        archivo.close();
+        if(archivo) {
+            archivo->cerrar();
+            resumen.filasEscritas = archivo->filasEscritas();
+        }
+        resumen.filasDescartadas = estado.descartadas;
+        resumen.segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        if(silencioso) return true;
+        
+        if(!avisos.empty()) cout << "Aviso: " << avisos << endl;
+        if(tiempoReal.activo) estadisticas.mostrar();
+        
+        cout << "Registro: anillo de " << anillo.capacidad() << " filas, ocupacion maxima "
+             << estado.ocupacionMax << ", filas descartadas " << estado.descartadas
+             << ", esperas del lazo " << estado.esperas << endl;
+        if(estado.descartadas > 0)
+            cout << "Aviso: el registrador no alcanzo al lazo de control; agrandar el anillo con --anillo N" << endl;
+        
+        imprimirResumen(cout, resumen);
+        if(archivoJSON == "-") {
+            escribirResumenJSON(cout, resumen);
+            cout << endl;
+        } else if(!archivoJSON.empty()) {
+            ofstream json(archivoJSON.c_str());
+            escribirResumenJSON(json, resumen);
+            json << endl;
+        }
         
         cout << "=====================================================" << endl;
         cout << "   SIMULACION COMPLETADA" << endl;
         cout << "=====================================================" << endl;
-        cout << "Resultados guardados en: " << nombreArchivo << endl;
+        if(!archivo) return true;
+        cout << "Resultados guardados en: " << nombreArchivo
+             << " (" << archivo->filasEscritas() << " filas)" << endl;
+        if(traza.binario) {
+            cout << "Para pasarlos a CSV: actividad2 --convertir " << nombreArchivo << endl;
+        }
         cout << "\nPara visualizar los resultados:" << endl;
         cout << "- Use MATLAB, Python (matplotlib), Excel, etc." << endl;
         cout << "- Grafique las columnas de interes vs Tiempo" << endl;
+        return true;
     }
     
     void generarScriptPython() {
+        if(!traza.guardar) return; // no hay datos que graficar
         cout << "\n¿Desea generar un script de Python para graficar? (s/n): ";
         char respuesta;
         cin >> respuesta;
@@ -319,9 +1451,10 @@ public:
             script << "axs[0].legend()\n";
             script << "axs[0].grid(True)\n\n";
             script << "# Grafica 2: Derivadas\n";
-            script << "axs[1].plot(datos['Tiempo'], datos['z1_Derivada1'], label='z1 (1ra derivada)')\n";
-            script << "axs[1].plot(datos['Tiempo'], datos['z2_Derivada2'], label='z2 (2da derivada)')\n";
-            script << "axs[1].plot(datos['Tiempo'], datos['z3_Derivada3'], label='z3 (3ra derivada)')\n";
+            for(int i = 1; i <= N; i++) {
+                script << "axs[1].plot(datos['Tiempo'], datos['z" << i << "_Derivada" << i
+                       << "'], label='z" << i << " (derivada " << i << ")')\n";
+            }
             script << "axs[1].set_xlabel('Tiempo (s)')\n";
             script << "axs[1].set_ylabel('Derivadas')\n";
             script << "axs[1].set_title('Derivadas de Orden Superior')\n";
@@ -339,8 +1472,1209 @@ public:
 };
 
 
-int main() {
-    SimuladorHIL simulador;
+// BARRIDO DE PARAMETROS (SIMULADOR POR LOTES)
+// para ajustar las ganancias del derivador hay que probar miles de combinaciones.
+// en vez de una simulacion por combinacion, se simulan todas juntas paso a paso:
+// cada configuracion es un "carril" y cada estado es un arreglo contiguo (z0[], z1[],
+// ..., estados de cada biquad de la planta[]), asi el lazo sobre los carriles no tiene
+// saltos y el compilador lo vectoriza (con -O3 -mavx2 procesa 4 carriles por instruccion).
+//
+// dentro del lazo no hay pow(): con n = 3 los exponentes de |error| son 3/4, 2/4, 1/4 y 0,
+// que salen de dos raices cuadradas. los coeficientes -lambda_i^(n-i) * L^((i+1)/(n+1))
+// no cambian durante la simulacion y se calculan una vez por carril.
+
+struct ConfigDerivador {
+    double lambda[4];
+    double L;
+};
+
+// resumen de una configuracion al final del barrido
+struct ResumenBarrido {
+    double rmsSeguimiento; // RMS de z0 - referencia
+    double maxSeguimiento; // maximo |z0 - referencia| despues del primer segundo
+    double rmsPlanta;      // RMS de y - referencia
+    double ruidoDerivada;  // RMS de la segunda diferencia de z1 (castañeteo)
+};
+
+template <typename Real = double>
+class SimuladorLotes {
+private:
+    static const size_t CARRILES_POR_BLOQUE = 512; // estados de un bloque entran en cache
+    
+    const vector<ConfigDerivador>& configs;
+    double tau;
+    vector<BiquadDF2T<Real> > secciones; // coeficientes de la planta (los estados van por carril)
+    
+    void simularBloque(size_t desde, size_t hasta, GeneradorSenal::TipoSenal tipo, int numMuestras,
+                       vector<ResumenBarrido>& resumen) {
+        size_t n = hasta - desde;
+        vector<Real> c0(n), c1(n), c2(n), c3(n);
+        vector<Real> z0(n, 0), z1(n, 0), z2(n, 0), z3(n, 0);
+        vector<Real> y(n, 0);
+        vector<Real> estados(2 * secciones.size() * n, 0); // s1 y s2 de cada seccion, por carril
+        vector<Real> sumaErr(n, 0), maxErr(n, 0), sumaErrY(n, 0), sumaRuido(n, 0);
+        vector<Real> z1Ant(n, 0), z1Ant2(n, 0);
+        
+        for(size_t j = 0; j < n; j++) {
+            const ConfigDerivador& c = configs[desde + j];
+            c0[j] = Real(-pow(c.lambda[0], 3.0) * pow(c.L, 0.25));
+            c1[j] = Real(-pow(c.lambda[1], 2.0) * pow(c.L, 0.5));
+            c2[j] = Real(-c.lambda[2] * pow(c.L, 0.75));
+            c3[j] = Real(-c.L);
+        }
+        
+        // punteros sin alias para que el compilador pueda vectorizar
+        Real* __restrict pz0 = &z0[0]; Real* __restrict pz1 = &z1[0];
+        Real* __restrict pz2 = &z2[0]; Real* __restrict pz3 = &z3[0];
+        Real* __restrict py = &y[0];
+        Real* __restrict pErr = &sumaErr[0]; Real* __restrict pMax = &maxErr[0];
+        Real* __restrict pErrY = &sumaErrY[0]; Real* __restrict pRuido = &sumaRuido[0];
+        Real* __restrict pAnt = &z1Ant[0]; Real* __restrict pAnt2 = &z1Ant2[0];
+        const Real* __restrict pc0 = &c0[0]; const Real* __restrict pc1 = &c1[0];
+        const Real* __restrict pc2 = &c2[0]; const Real* __restrict pc3 = &c3[0];
+        
+        const Real t1 = Real(tau), t2 = Real(tau * tau / 2.0), t3 = Real(tau * tau * tau / 6.0);
+        const Real umbral = Escalar<Real>::umbralSigno(), uno = 1, cero = 0, dos = 2;
+        
+        for(int k = 0; k < numMuestras; k++) {
+            double t = k * tau;
+            Real ref = Real(GeneradorSenal::generar(tipo, t)); // la misma para todos los carriles
+            Real pesoMax = (t >= 1.0) ? uno : cero;
+            Real pesoRuido = (k >= 2) ? uno : cero;
+            
+            for(size_t j = 0; j < n; j++) {
+                // derivador
+                Real e = pz0[j] - ref;
+                Real ae = fabs(e);
+                Real r2 = sqrt(ae);          // |e|^(1/2)
+                Real r4 = sqrt(r2);          // |e|^(1/4)
+                Real s = (ae < umbral) ? cero : copysign(uno, e);
+                Real phi0 = pc0[j] * r2 * r4 * s;
+                Real phi1 = pc1[j] * r2 * s;
+                Real phi2 = pc2[j] * r4 * s;
+                Real phi3 = pc3[j] * s;
+                
+                Real n0 = pz0[j] + t1 * phi0 + t1 * pz1[j] + t2 * pz2[j] + t3 * pz3[j];
+                Real n1 = pz1[j] + t1 * phi1 + t1 * pz2[j] + t2 * pz3[j];
+                Real n2 = pz2[j] + t1 * phi2 + t1 * pz3[j];
+                Real n3 = pz3[j] + t1 * phi3;
+                pz0[j] = n0; pz1[j] = n1; pz2[j] = n2; pz3[j] = n3;
+                py[j] = n0;
+            }
+            
+            // planta (recibe z0): una pasada por seccion, cada una sobre todos los carriles
+            for(size_t sec = 0; sec < secciones.size(); sec++) {
+                const BiquadDF2T<Real>& q = secciones[sec];
+                Real* __restrict s1 = &estados[2 * sec * n];
+                Real* __restrict s2 = &estados[(2 * sec + 1) * n];
+                for(size_t j = 0; j < n; j++) {
+                    Real x = py[j];
+                    Real salida = q.b0 * x + s1[j];
+                    s1[j] = q.b1 * x - q.a1 * salida + s2[j];
+                    s2[j] = q.b2 * x - q.a2 * salida;
+                    py[j] = salida;
+                }
+            }
+            
+            // metricas
+            for(size_t j = 0; j < n; j++) {
+                Real n0 = pz0[j], n1 = pz1[j], y = py[j];
+                Real err = n0 - ref;
+                pErr[j] += err * err;
+                Real aerr = fabs(err) * pesoMax;
+                pMax[j] = (aerr > pMax[j]) ? aerr : pMax[j];
+                Real errY = y - ref;
+                pErrY[j] += errY * errY;
+                Real dd = n1 - dos * pAnt[j] + pAnt2[j];
+                pRuido[j] += dd * dd * pesoRuido;
+                pAnt2[j] = pAnt[j];
+                pAnt[j] = n1;
+            }
+        }
+        
+        for(size_t j = 0; j < n; j++) {
+            ResumenBarrido& r = resumen[desde + j];
+            r.rmsSeguimiento = sqrt((double)sumaErr[j] / numMuestras);
+            r.maxSeguimiento = maxErr[j];
+            r.rmsPlanta = sqrt((double)sumaErrY[j] / numMuestras);
+            r.ruidoDerivada = sqrt((double)sumaRuido[j] / max(1, numMuestras - 2));
+        }
+    }
+    
+public:
+    SimuladorLotes(const vector<ConfigDerivador>& c, double tauMuestreo, const PlantaSISO& planta)
+        : configs(c), tau(tauMuestreo) {
+        for(size_t i = 0; i < planta.getSecciones().size(); i++) {
+            secciones.push_back(BiquadDF2T<Real>(planta.getSecciones()[i]));
+        }
+    }
+    
+    vector<ResumenBarrido> ejecutar(GeneradorSenal::TipoSenal tipo, double tiempo) {
+        vector<ResumenBarrido> resumen(configs.size());
+        int numMuestras = (int)(tiempo / tau);
+        for(size_t desde = 0; desde < configs.size(); desde += CARRILES_POR_BLOQUE) {
+            simularBloque(desde, min(configs.size(), desde + CARRILES_POR_BLOQUE), tipo, numMuestras, resumen);
+        }
+        return resumen;
+    }
+};
+
+// lee configuraciones "lambda0 lambda1 lambda2 lambda3 L" (una por linea, # = comentario)
+bool leerConfiguraciones(const string& ruta, vector<ConfigDerivador>& configs) {
+    ifstream archivo(ruta.c_str());
+    if(!archivo) return false;
+    string linea;
+    while(getline(archivo, linea)) {
+        if(linea.empty() || linea[0] == '#') continue;
+        istringstream in(linea);
+        ConfigDerivador c;
+        if(in >> c.lambda[0] >> c.lambda[1] >> c.lambda[2] >> c.lambda[3] >> c.L) configs.push_back(c);
+    }
+    return true;
+}
+
+// imprime N configuraciones al azar alrededor de las ganancias del enunciado (+-50%)
+void generarConfiguraciones(int cantidad, unsigned semilla) {
+    mt19937 rng(semilla);
+    uniform_real_distribution<double> factor(0.5, 1.5);
+    const double base[] = {lambda0, lambda1, lambda2, lambda3, L};
+    cout << "# lambda0 lambda1 lambda2 lambda3 L" << endl;
+    for(int i = 0; i < cantidad; i++) {
+        for(int k = 0; k < 5; k++) {
+            cout << setprecision(6) << base[k] * factor(rng) << (k < 4 ? ' ' : '\n');
+        }
+    }
+}
+
+// con simple = true los carriles van en float: el doble de carriles por registro SIMD
+void ejecutarBarrido(const string& ruta, GeneradorSenal::TipoSenal tipo, double tiempo, const PlantaSISO& planta,
+                     bool simple) {
+    vector<ConfigDerivador> configs;
+    if(!leerConfiguraciones(ruta, configs) || configs.empty()) {
+        cerr << "No se pudieron leer configuraciones de " << ruta << endl;
+        return;
+    }
+    
+    chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+    vector<ResumenBarrido> resumen = simple ? SimuladorLotes<float>(configs, tau_s, planta).ejecutar(tipo, tiempo)
+                                            : SimuladorLotes<double>(configs, tau_s, planta).ejecutar(tipo, tiempo);
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    
+    cout << "lambda0,lambda1,lambda2,lambda3,L,rms_seguimiento,max_seguimiento,rms_planta,ruido_z1" << endl;
+    size_t mejor = 0;
+    for(size_t i = 0; i < configs.size(); i++) {
+        const ConfigDerivador& c = configs[i];
+        const ResumenBarrido& r = resumen[i];
+        cout << setprecision(6) << c.lambda[0] << "," << c.lambda[1] << "," << c.lambda[2] << ","
+             << c.lambda[3] << "," << c.L << "," << r.rmsSeguimiento << "," << r.maxSeguimiento << ","
+             << r.rmsPlanta << "," << r.ruidoDerivada << "\n";
+        if(r.rmsSeguimiento < resumen[mejor].rmsSeguimiento) mejor = i;
+    }
+    cout.flush();
+    
+    long long pasos = (long long)configs.size() * (long long)(tiempo / tau_s);
+    cerr << configs.size() << " configuraciones x " << tiempo << " s (" << GeneradorSenal::getNombre(tipo)
+         << ", " << (simple ? "float" : "double") << ") en " << fixed << setprecision(3) << segundos << " s, "
+         << setprecision(1) << pasos / segundos / 1e6 << " millones de pasos/s" << endl;
+    cerr << "Menor error RMS de seguimiento: configuracion " << mejor + 1
+         << " (" << setprecision(6) << resumen[mejor].rmsSeguimiento << ")" << endl;
+}
+
+
+// VERIFICACION DEL DERIVADOR
+// convergencia de un orden con sus ganancias por defecto: en la segunda mitad de la
+// corrida z0 tiene que seguir a la señal y z1 a su derivada (la corrida dura por lo
+// menos 20 s: despues del escalon en t = 1 s el orden 3 tarda varios segundos). solo escalon y rampa, que
+// cumplen la cota de Lipschitz de la derivada N+1; la senoidal (derivadas de hasta
+// pi^(N+1)) no, y ahi el error queda acotado pero no tiende a cero
+template <int N>
+bool verificarConvergencia(double tiempo) {
+    const double toleranciaSenal = 1e-2, toleranciaDerivada = 5e-2;
+    bool ok = true;
+    for(int senal = 1; senal <= 2; senal++) {
+        GeneradorSenal::TipoSenal tipo = static_cast<GeneradorSenal::TipoSenal>(senal);
+        DerivadorOrden<N> derivador;
+        double peorSenal = 0.0, peorDerivada = 0.0;
+        int muestras = (int)(tiempo / tau_s);
+        for(int k = 0; k < muestras; k++) {
+            double t = k * tau_s;
+            double ref = GeneradorSenal::generar(tipo, t);
+            derivador.actualizar(ref);
+            if(2 * k < muestras) continue;
+            // con !(x <= peor) un NaN queda como el peor y la comparacion de abajo falla
+            double errorSenal = fabs(derivador.z[0] - ref);
+            double errorDerivada = fabs(derivador.z[1] - GeneradorSenal::derivada(tipo, t, 1));
+            if(!(errorSenal <= peorSenal)) peorSenal = errorSenal;
+            if(!(errorDerivada <= peorDerivada)) peorDerivada = errorDerivada;
+        }
+        bool bien = peorSenal <= toleranciaSenal && peorDerivada <= toleranciaDerivada;
+        ok = ok && bien;
+        cout << "  orden " << N << setw(9) << GeneradorSenal::getNombre(tipo) << ": |z0 - f| max " << scientific
+             << setprecision(2) << peorSenal << ", |z1 - f'| max " << peorDerivada << defaultfloat
+             << setprecision(6) << (bien ? "  OK" : "  FALLA") << endl;
+    }
+    return ok;
+}
+
+// compara la version por plantilla (sin pow en el lazo) con la original muestra a
+// muestra para las tres señales; las raices encadenadas y pow() difieren en el ultimo
+// bit, asi que se acepta un error relativo chico
+bool verificarDerivador(double tiempo) {
+    const double tolerancia = 1e-9;
+    bool ok = true;
+    cout << "=== VERIFICACION: DerivadorOrden<3> vs implementacion original ===" << endl;
+    for(int senal = 1; senal <= 3; senal++) {
+        GeneradorSenal::TipoSenal tipo = static_cast<GeneradorSenal::TipoSenal>(senal);
+        DerivadorReferencia original;
+        Derivador nuevo;
+        double peor = 0.0;
+        int muestras = (int)(tiempo / tau_s);
+        for(int k = 0; k < muestras; k++) {
+            double ref = GeneradorSenal::generar(tipo, k * tau_s);
+            original.actualizar(ref);
+            nuevo.actualizar(ref);
+            double esperado[] = {original.z0, original.z1, original.z2, original.z3};
+            for(int i = 0; i <= 3; i++) {
+                double diferencia = fabs(nuevo.z[i] - esperado[i]) / max(1.0, fabs(esperado[i]));
+                peor = max(peor, diferencia);
+            }
+        }
+        bool bien = peor <= tolerancia;
+        ok = ok && bien;
+        cout << setw(9) << GeneradorSenal::getNombre(tipo) << ": error relativo maximo " << scientific
+             << setprecision(2) << peor << defaultfloat << (bien ? "  OK" : "  FALLA") << endl;
+    }
+    cout << (ok ? "Todas las señales coinciden." : "La version por plantilla NO coincide con la original.") << endl;
+    
+    // cada orden que acepta --orden, con sus ganancias por defecto
+    double duracion = max(tiempo, 20.0);
+    cout << "=== VERIFICACION: convergencia de los ordenes 1 a " << ORDEN_MAXIMO_DERIVADOR
+         << " (segunda mitad de " << duracion << " s) ===" << endl;
+    bool convergen = verificarConvergencia<1>(duracion);
+    convergen = verificarConvergencia<2>(duracion) && convergen;
+    convergen = verificarConvergencia<3>(duracion) && convergen;
+    convergen = verificarConvergencia<4>(duracion) && convergen;
+    convergen = verificarConvergencia<5>(duracion) && convergen;
+    cout << (convergen ? "Todos los ordenes convergen." : "Algun orden NO converge.") << endl;
+    return ok && convergen;
+}
+
+// VERIFICACION DE LA PLANTA
+// Tustin cumple exactamente G(z = e^(jwT)) = G(s = jK tan(wT/2)), asi que la cascada de
+// biquads se puede comparar con G(s) sin simular; se prueba a varias frecuencias de
+// muestreo, con y sin prewarp
+bool verificarPlanta(const PlantaSISO& referencia) {
+    // con polos cerca de z = 1 el redondeo de los coeficientes de cada biquad ya da ~1e-9
+    const double tolerancia = 1e-7;
+    const double frecuencias[] = {250.0, 1000.0, 10000.0};
+    const double prewarps[] = {0.0, 2.0 * M_PI * 0.5};
+    bool ok = true;
+    cout << "=== VERIFICACION: discretizacion de " << referencia.descripcion() << " ===" << endl;
+    for(int f = 0; f < 3; f++) {
+        for(int p = 0; p < 2; p++) {
+            double T = 1.0 / frecuencias[f];
+            double w0 = prewarps[p];
+            double K = (w0 > 0) ? w0 / tan(w0 * T / 2.0) : 2.0 / T;
+            PlantaSISO planta(referencia);
+            if(!planta.definir(referencia.numerador(), referencia.denominador(), T, w0)) return false;
+            double peor = 0.0;
+            for(double w = 0.0; w < M_PI / T; w += 0.01 * M_PI / T) {
+                Complejo discreta = planta.respuestaDiscreta(polar(1.0, w * T));
+                Complejo continua = planta.respuestaContinua(Complejo(0.0, K * tan(w * T / 2.0)));
+                peor = max(peor, abs(discreta - continua) / max(1.0, abs(continua)));
+            }
+            bool bien = peor <= tolerancia;
+            ok = ok && bien;
+            cout << setw(6) << frecuencias[f] << " Hz, " << (w0 > 0 ? "prewarp 0.5 Hz" : "sin prewarp   ")
+                 << ": " << planta.getSecciones().size() << " secciones, error relativo maximo "
+                 << scientific << setprecision(2) << peor << defaultfloat << setprecision(6)
+                 << (bien ? "  OK" : "  FALLA") << endl;
+        }
+    }
+    cout << "Ganancia en continua: G(0) = " << referencia.respuestaContinua(0.0).real()
+         << ", G(z=1) = " << referencia.respuestaDiscreta(1.0).real() << endl;
+    cout << (ok ? "La discretizacion coincide con G(s)." : "La discretizacion NO coincide con G(s).") << endl;
+    return ok;
+}
+
+// lee "7 -28 21" (coeficientes de mayor a menor potencia)
+vector<double> leerPolinomio(const string& texto) {
+    vector<double> c;
+    istringstream in(texto);
+    double v;
+    while(in >> v) c.push_back(v);
+    return c;
+}
+
+// COMPARACION DE PRECISION
+// el lazo completo (derivador de orden 3 y planta) en float y en punto fijo Q7.24, lado a
+// lado con double: para cada señal, la diferencia maxima y RMS de z0..z3 e y contra la
+// corrida en double, y el tiempo por paso. la referencia se genera en double y se
+// redondea al tipo del lazo, como si viniera de un ADC.
+
+const int VARIABLES_PRECISION = 5; // z0..z3 e y
+const char* const nombresVariablesPrecision[VARIABLES_PRECISION] = {"z0", "z1", "z2", "z3", "y"};
+
+// devuelve z0..z3 e y de cada muestra pasados a double
+template <typename Real>
+vector<double> correrEnPrecision(GeneradorSenal::TipoSenal tipo, long long muestras, const PlantaSISO& nominal,
+                                 double& nsPorPaso) {
+    DerivadorOrden<3, Real> derivador;
+    PlantaGenerica<Real> planta(nominal);
+    planta.reset();
+    vector<double> valores(muestras * VARIABLES_PRECISION);
+    long long inicio = ahoraNs();
+    for(long long k = 0; k < muestras; k++) {
+        derivador.actualizar(Real(GeneradorSenal::generar(tipo, k * tau_s)));
+        Real y = planta.actualizar(derivador.z[0]);
+        double* fila = &valores[k * VARIABLES_PRECISION];
+        for(int i = 0; i <= 3; i++) fila[i] = (double)derivador.z[i];
+        fila[4] = (double)y;
+    }
+    nsPorPaso = (double)(ahoraNs() - inicio) / muestras;
+    return valores;
+}
+
+template <typename Real>
+void informarPrecision(const vector<double>& referencia, GeneradorSenal::TipoSenal tipo, long long muestras,
+                       const PlantaSISO& nominal) {
+    double ns;
+    vector<double> valores = correrEnPrecision<Real>(tipo, muestras, nominal, ns);
+    double maximo[VARIABLES_PRECISION] = {0}, suma[VARIABLES_PRECISION] = {0};
+    for(size_t j = 0; j < valores.size(); j++) {
+        double d = fabs(valores[j] - referencia[j]);
+        int i = j % VARIABLES_PRECISION;
+        maximo[i] = max(maximo[i], d);
+        suma[i] += d * d;
+    }
+    cout << left << setw(10) << Escalar<Real>::nombre() << setw(5) << "max" << right << scientific << setprecision(2);
+    for(int i = 0; i < VARIABLES_PRECISION; i++) cout << setw(11) << maximo[i];
+    cout << fixed << setprecision(1) << setw(10) << ns << endl;
+    cout << setw(10) << "" << left << setw(5) << "rms" << right << scientific << setprecision(2);
+    for(int i = 0; i < VARIABLES_PRECISION; i++) cout << setw(11) << sqrt(suma[i] / muestras);
+    cout << defaultfloat << endl;
+}
+
+void compararPrecision(double tiempo, const PlantaSISO& planta) {
+    long long muestras = (long long)(tiempo / tau_s);
+    if(muestras <= 0) return;
+    cout << "=== COMPARACION DE PRECISION CONTRA DOUBLE (" << tiempo << " s, " << muestras << " muestras) ===" << endl;
+    for(int senal = 1; senal <= 3; senal++) {
+        GeneradorSenal::TipoSenal tipo = static_cast<GeneradorSenal::TipoSenal>(senal);
+        double ns;
+        vector<double> referencia = correrEnPrecision<double>(tipo, muestras, planta, ns);
+        
+        cout << "\n" << GeneradorSenal::getNombre(tipo) << endl;
+        cout << left << setw(15) << "tipo" << right;
+        for(int i = 0; i < VARIABLES_PRECISION; i++) cout << setw(11) << nombresVariablesPrecision[i];
+        cout << setw(10) << "ns/paso" << endl;
+        cout << left << setw(15) << "double" << right << setw(11 * VARIABLES_PRECISION + 10) << fixed
+             << setprecision(1) << ns << defaultfloat << endl;
+        informarPrecision<float>(referencia, tipo, muestras, planta);
+        informarPrecision<Q24>(referencia, tipo, muestras, planta);
+    }
+}
+
+
+// ESCENARIOS (MODO SIN TECLADO)
+// un archivo con una simulacion por linea, para las regresiones nocturnas:
+//   nombre clave=valor clave=valor ...
+// claves: senal (1|2|3 o escalon|rampa|senoidal), tiempo, orden, lambdas (separadas por
+// comas, orden+1 valores), L, num, den (coeficientes de G(s) separados por comas), prewarp
+// y salida (por defecto <nombre>.txt). lo que no se da queda como en el modo interactivo.
+// los escenarios se reparten entre varios hilos, cada uno con su propio SimuladorHIL.
+
+struct Escenario {
+    string nombre;
+    GeneradorSenal::TipoSenal senal;
+    double tiempo;
+    int orden;
+    vector<double> lambdas; // vacio = ganancias por defecto
+    double L;
+    vector<double> num, den;
+    double prewarp;
+    string salida;
+    string error;           // linea mal escrita
+    
+    Escenario() : senal(GeneradorSenal::ESCALON), tiempo(10.0), orden(3), L(::L), prewarp(0.0) {}
+};
+
+struct ResultadoEscenario {
+    bool ok;
+    string error;
+    ResumenSimulacion resumen;
+    
+    ResultadoEscenario() : ok(false) {}
+};
+
+bool leerEscenarios(const string& ruta, vector<Escenario>& escenarios) {
+    ifstream archivo(ruta.c_str());
+    if(!archivo) return false;
+    string linea;
+    while(getline(archivo, linea)) {
+        if(linea.find_first_not_of(" \t\r") == string::npos || linea[linea.find_first_not_of(" \t")] == '#') continue;
+        istringstream in(linea);
+        Escenario e;
+        in >> e.nombre;
+        string campo;
+        while(in >> campo) {
+            size_t igual = campo.find('=');
+            string clave = campo.substr(0, igual);
+            string valor = (igual == string::npos) ? "" : campo.substr(igual + 1);
+            string lista = valor;
+            replace(lista.begin(), lista.end(), ',', ' ');
+            if(clave == "senal") {
+                if(valor == "1" || valor == "escalon") e.senal = GeneradorSenal::ESCALON;
+                else if(valor == "2" || valor == "rampa") e.senal = GeneradorSenal::RAMPA;
+                else if(valor == "3" || valor == "senoidal") e.senal = GeneradorSenal::SENOIDAL;
+                else e.error = "senal desconocida: " + valor;
+            }
+            else if(clave == "tiempo") e.tiempo = atof(valor.c_str());
+            else if(clave == "orden") e.orden = atoi(valor.c_str());
+            else if(clave == "lambdas") e.lambdas = leerPolinomio(lista);
+            else if(clave == "L") e.L = atof(valor.c_str());
+            else if(clave == "num") e.num = leerPolinomio(lista);
+            else if(clave == "den") e.den = leerPolinomio(lista);
+            else if(clave == "prewarp") e.prewarp = atof(valor.c_str());
+            else if(clave == "salida") e.salida = valor;
+            else e.error = "clave desconocida: " + clave;
+        }
+        if(e.error.empty() && e.tiempo <= 0) e.error = "tiempo invalido";
+        if(e.error.empty() && (e.orden < 1 || e.orden > ORDEN_MAXIMO_DERIVADOR)) e.error = "orden fuera de 1..5";
+        if(e.error.empty() && !e.lambdas.empty() && (int)e.lambdas.size() != e.orden + 1)
+            e.error = "hacen falta orden+1 lambdas";
+        if(e.salida.empty()) e.salida = e.nombre + ".txt";
+        escenarios.push_back(e);
+    }
+    return true;
+}
+
+template <int N>
+ResultadoEscenario correrEscenario(const Escenario& e, const PlantaSISO& planta, const OpcionesTraza& traza) {
+    ResultadoEscenario r;
+    SimuladorHIL<N> simulador(traza, OpcionesTiempoReal(), planta);
+    simulador.configurar(e.senal, e.tiempo, e.salida);
+    if(!e.lambdas.empty() || e.L != L) simulador.setGanancias(e.L, e.lambdas.empty() ? NULL : &e.lambdas[0]);
+    if(!simulador.ejecutar()) {
+        r.error = "no se pudo crear " + e.salida;
+        return r;
+    }
+    r.ok = true;
+    r.resumen = simulador.getResumen();
+    return r;
+}
+
+ResultadoEscenario correrEscenario(const Escenario& e, const PlantaSISO& plantaPorDefecto, const OpcionesTraza& traza) {
+    ResultadoEscenario r;
+    if(!e.error.empty()) {
+        r.error = e.error;
+        return r;
+    }
+    PlantaSISO planta(plantaPorDefecto);
+    if((!e.num.empty() || !e.den.empty() || e.prewarp > 0) &&
+       !planta.definir(e.num.empty() ? plantaPorDefecto.numerador() : e.num,
+                       e.den.empty() ? plantaPorDefecto.denominador() : e.den, tau_s, e.prewarp)) {
+        r.error = "planta invalida";
+        return r;
+    }
+    switch(e.orden) {
+        case 1: return correrEscenario<1>(e, planta, traza);
+        case 2: return correrEscenario<2>(e, planta, traza);
+        case 4: return correrEscenario<4>(e, planta, traza);
+        case 5: return correrEscenario<5>(e, planta, traza);
+        default: return correrEscenario<3>(e, planta, traza);
+    }
+}
+
+// corre todos los escenarios y muestra la tabla; false si alguno fallo
+bool ejecutarEscenarios(const string& ruta, int numHilos, const OpcionesTraza& traza, const PlantaSISO& planta,
+                        const string& archivoJSON) {
+    vector<Escenario> escenarios;
+    if(!leerEscenarios(ruta, escenarios) || escenarios.empty()) {
+        cerr << "No se pudieron leer escenarios de " << ruta << endl;
+        return false;
+    }
+    if(numHilos <= 0) numHilos = (int)thread::hardware_concurrency();
+    if(numHilos <= 0) numHilos = 1;
+    numHilos = min(numHilos, (int)escenarios.size());
+    
+    vector<ResultadoEscenario> resultados(escenarios.size());
+    chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+    atomic<size_t> siguiente(0);
+    vector<thread> hilos;
+    for(int h = 0; h < numHilos; h++) {
+        hilos.push_back(thread([&]() {
+            while(true) {
+                size_t k = siguiente.fetch_add(1);
+                if(k >= escenarios.size()) break;
+                resultados[k] = correrEscenario(escenarios[k], planta, traza);
+            }
+        }));
+    }
+    for(size_t h = 0; h < hilos.size(); h++) hilos[h].join();
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    
+    int fallidos = 0;
+    cout << left << setw(20) << "escenario" << setw(10) << "senal" << right << setw(8) << "tiempo"
+         << setw(7) << "orden" << setw(12) << "rms_seguim" << setw(12) << "max_seguim"
+         << setw(12) << "rms_planta" << setw(9) << "filas" << setw(9) << "seg" << "  estado" << endl;
+    for(size_t k = 0; k < escenarios.size(); k++) {
+        const Escenario& e = escenarios[k];
+        const ResultadoEscenario& r = resultados[k];
+        cout << left << setw(20) << e.nombre << setw(10) << GeneradorSenal::getNombre(e.senal) << right
+             << setw(8) << e.tiempo << setw(7) << e.orden;
+        if(r.ok) {
+            cout << setprecision(6) << setw(12) << r.resumen.rmsSeguimiento() << setw(12) << r.resumen.maxSeguimiento
+                 << setw(12) << r.resumen.rmsPlanta() << setw(9) << r.resumen.filasEscritas
+                 << fixed << setprecision(3) << setw(9) << r.resumen.segundos << defaultfloat << "  ok" << endl;
+        } else {
+            fallidos++;
+            cout << setw(12) << "-" << setw(12) << "-" << setw(12) << "-" << setw(9) << "-" << setw(9) << "-"
+                 << "  error: " << r.error << endl;
+        }
+    }
+    cout.flush();
+    
+    // todas las medidas de cada escenario, para comparar entre corridas
+    if(!archivoJSON.empty()) {
+        ofstream archivo;
+        if(archivoJSON != "-") archivo.open(archivoJSON.c_str());
+        ostream& json = (archivoJSON == "-") ? cout : archivo;
+        json << "[";
+        for(size_t k = 0; k < escenarios.size(); k++) {
+            json << (k ? ",\n " : "") << "{\"escenario\": \"" << escenarios[k].nombre << "\", \"ok\": "
+                 << (resultados[k].ok ? "true" : "false") << ", \"medidas\": ";
+            if(resultados[k].ok) escribirResumenJSON(json, resultados[k].resumen);
+            else json << "null";
+            json << "}";
+        }
+        json << "]" << endl;
+    }
+    cerr << escenarios.size() << " escenarios en " << fixed << setprecision(3) << segundos << " s con "
+         << numHilos << " hilos, " << fallidos << " con error" << endl;
+    return fallidos == 0;
+}
+
+// MONTE CARLO
+// miles de corridas con ruido de medicion en la referencia que recibe el derivador y
+// con los coeficientes de G(s) perturbados (se vuelve a discretizar en cada ensayo).
+//
+// los numeros aleatorios salen de un generador por contador (Philox4x32-10): cada valor
+// es una funcion de (semilla, flujo, ensayo, muestra), asi que no importa que hilo corre
+// cada ensayo ni en que orden. los ensayos se corren de a bloques y las medidas de cada
+// bloque se acumulan en orden de ensayo, con lo que el resultado es identico con
+// cualquier cantidad de hilos. de cada medida se guarda un histograma logaritmico (1% de
+// resolucion) en vez de todos los valores: la memoria no crece con la cantidad de ensayos.
+
+class AleatorioContador {
+private:
+    uint32_t clave[2];
+    
+public:
+    enum Flujo { RUIDO = 0, PLANTA = 1 };
+    
+    explicit AleatorioContador(uint64_t semilla) {
+        clave[0] = (uint32_t)semilla;
+        clave[1] = (uint32_t)(semilla >> 32);
+    }
+    
+    // 10 rondas de Philox4x32 sobre el contador (indice, flujo, ensayo)
+    void bloque(uint64_t ensayo, uint32_t flujo, uint32_t indice, uint32_t salida[4]) const {
+        uint32_t c[4] = {indice, flujo, (uint32_t)ensayo, (uint32_t)(ensayo >> 32)};
+        uint32_t k[2] = {clave[0], clave[1]};
+        for(int ronda = 0; ronda < 10; ronda++) {
+            uint64_t p0 = (uint64_t)0xD2511F53u * c[0];
+            uint64_t p1 = (uint64_t)0xCD9E8D57u * c[2];
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c[1] ^ k[0];
+            uint32_t n2 = (uint32_t)(p0 >> 32) ^ c[3] ^ k[1];
+            c[0] = n0; c[1] = (uint32_t)p1; c[2] = n2; c[3] = (uint32_t)p0;
+            k[0] += 0x9E3779B9u;
+            k[1] += 0xBB67AE85u;
+        }
+        for(int i = 0; i < 4; i++) salida[i] = c[i];
+    }
+    
+    // uniforme en [0, 1) con 53 bits
+    static double aUniforme(uint32_t alto, uint32_t bajo) {
+        return (double)((((uint64_t)alto << 32) | bajo) >> 11) * (1.0 / 9007199254740992.0);
+    }
+    
+    double uniforme(uint64_t ensayo, uint32_t flujo, uint32_t indice) const {
+        uint32_t x[4];
+        bloque(ensayo, flujo, indice, x);
+        return aUniforme(x[0], x[1]);
+    }
+    
+    // normal estandar (Box-Muller con las dos mitades del bloque)
+    double normal(uint64_t ensayo, uint32_t flujo, uint32_t indice) const {
+        uint32_t x[4];
+        bloque(ensayo, flujo, indice, x);
+        double u1 = aUniforme(x[0], x[1]), u2 = aUniforme(x[2], x[3]);
+        return sqrt(-2.0 * log(1.0 - u1)) * cos(2.0 * M_PI * u2);
+    }
+};
+
+// minimo, maximo, media y cuantiles aproximados (histograma logaritmico) de una medida
+class EstadisticaCuantiles {
+private:
+    static constexpr double MINIMO = 1e-12;
+    static constexpr double FACTOR = 1.01;
+    static const int CUBETAS = 5560; // de 1e-12 a 1e12
+    
+    vector<long long> histograma;
+    long long cantidad, noFinitos;
+    double suma, minimo, maximo;
+    
+public:
+    EstadisticaCuantiles() : histograma(CUBETAS, 0), cantidad(0), noFinitos(0), suma(0), minimo(1e300), maximo(-1e300) {}
+    
+    void agregar(double v) {
+        if(!std::isfinite(v)) { noFinitos++; return; }
+        cantidad++;
+        suma += v;
+        minimo = min(minimo, v);
+        maximo = max(maximo, v);
+        int cubeta = (v <= MINIMO) ? 0 : (int)(log(v / MINIMO) / log(FACTOR));
+        histograma[min(max(cubeta, 0), CUBETAS - 1)]++;
+    }
+    
+    long long getCantidad() const { return cantidad; }
+    long long getNoFinitos() const { return noFinitos; }
+    double media() const { return cantidad ? suma / cantidad : 0.0; }
+    double getMinimo() const { return cantidad ? minimo : 0.0; }
+    double getMaximo() const { return cantidad ? maximo : 0.0; }
+    
+    // centro geometrico de la cubeta donde cae el cuantil q (error relativo <= 0.5%)
+    double cuantil(double q) const {
+        if(cantidad == 0) return 0.0;
+        long long rango = max(1LL, (long long)ceil(q * cantidad)), acumulado = 0;
+        for(int i = 0; i < CUBETAS; i++) {
+            acumulado += histograma[i];
+            if(acumulado >= rango) {
+                double v = (i == 0) ? minimo : MINIMO * pow(FACTOR, i + 0.5);
+                return min(max(v, minimo), maximo);
+            }
+        }
+        return maximo;
+    }
+};
+
+struct OpcionesMonteCarlo {
+    long long ensayos;
+    uint64_t semilla;
+    double ruido;          // desvio estandar del ruido sumado a la referencia
+    double incertidumbre;  // cada coeficiente de G(s) se multiplica por 1 +- incertidumbre (uniforme)
+    GeneradorSenal::TipoSenal senal;
+    double tiempo;
+    int hilos;
+    
+    OpcionesMonteCarlo() : ensayos(1000), semilla(12345), ruido(0.01), incertidumbre(0.1),
+                           senal(GeneradorSenal::ESCALON), tiempo(10.0), hilos(0) {}
+};
+
+// medidas de un ensayo
+struct MedidasEnsayo {
+    static const int CANTIDAD = 4;
+    double valor[CANTIDAD]; // rms_seguimiento, max_seguimiento, rms_planta, ruido_z1
+    bool valido;
+};
+
+const char* const nombresMedidasMonteCarlo[MedidasEnsayo::CANTIDAD] = {
+    "rms_seguimiento", "max_seguimiento", "rms_planta", "ruido_z1"
+};
+
+MedidasEnsayo simularEnsayo(long long ensayo, const OpcionesMonteCarlo& op, const PlantaSISO& nominal,
+                            const AleatorioContador& aleatorio) {
+    MedidasEnsayo m;
+    vector<double> num = nominal.numerador(), den = nominal.denominador();
+    uint32_t indice = 0;
+    for(size_t i = 0; i < num.size(); i++)
+        num[i] *= 1.0 + op.incertidumbre * (2.0 * aleatorio.uniforme(ensayo, AleatorioContador::PLANTA, indice++) - 1.0);
+    for(size_t i = 0; i < den.size(); i++)
+        den[i] *= 1.0 + op.incertidumbre * (2.0 * aleatorio.uniforme(ensayo, AleatorioContador::PLANTA, indice++) - 1.0);
+    PlantaSISO planta(nominal);
+    m.valido = planta.definir(num, den, tau_s, 0.0);
+    if(!m.valido) return m;
+    
+    Derivador derivador;
+    ResumenSimulacion resumen;
+    double z1Ant = 0.0, z1Ant2 = 0.0, sumaRuido = 0.0;
+    int muestras = (int)(op.tiempo / tau_s);
+    double t = 0.0;
+    for(int k = 0; k < muestras; k++) {
+        double ref = GeneradorSenal::generar(op.senal, t);
+        double medida = ref + (op.ruido > 0 ? op.ruido * aleatorio.normal(ensayo, AleatorioContador::RUIDO, (uint32_t)k) : 0.0);
+        derivador.actualizar(medida);
+        double y = planta.actualizar(derivador.z[0]);
+        resumen.acumular(t, ref, y, derivador.z[0]);
+        double dd = derivador.z[1] - 2.0 * z1Ant + z1Ant2;
+        if(k >= 2) sumaRuido += dd * dd;
+        z1Ant2 = z1Ant;
+        z1Ant = derivador.z[1];
+        t += tau_s;
+    }
+    m.valor[0] = resumen.rmsSeguimiento();
+    m.valor[1] = resumen.maxSeguimiento;
+    m.valor[2] = resumen.rmsPlanta();
+    m.valor[3] = sqrt(sumaRuido / max(1, muestras - 2));
+    return m;
+}
+
+void ejecutarMonteCarlo(const OpcionesMonteCarlo& op, const PlantaSISO& nominal) {
+    const long long ENSAYOS_POR_BLOQUE = 1024;
+    int numHilos = op.hilos > 0 ? op.hilos : (int)thread::hardware_concurrency();
+    if(numHilos <= 0) numHilos = 1;
+    
+    AleatorioContador aleatorio(op.semilla);
+    EstadisticaCuantiles estadisticas[MedidasEnsayo::CANTIDAD];
+    long long invalidos = 0;
+    vector<MedidasEnsayo> bloque(ENSAYOS_POR_BLOQUE);
+    chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+    
+    for(long long desde = 0; desde < op.ensayos; desde += ENSAYOS_POR_BLOQUE) {
+        long long cantidad = min(ENSAYOS_POR_BLOQUE, op.ensayos - desde);
+        atomic<long long> siguiente(0);
+        vector<thread> hilos;
+        for(int h = 0; h < min<long long>(numHilos, cantidad); h++) {
+            hilos.push_back(thread([&]() {
+                while(true) {
+                    long long k = siguiente.fetch_add(1);
+                    if(k >= cantidad) break;
+                    bloque[k] = simularEnsayo(desde + k, op, nominal, aleatorio);
+                }
+            }));
+        }
+        for(size_t h = 0; h < hilos.size(); h++) hilos[h].join();
+        
+        // en orden de ensayo, para que el resultado no dependa de los hilos
+        for(long long k = 0; k < cantidad; k++) {
+            if(!bloque[k].valido) { invalidos++; continue; }
+            for(int i = 0; i < MedidasEnsayo::CANTIDAD; i++) estadisticas[i].agregar(bloque[k].valor[i]);
+        }
+    }
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    
+    cout << "=== MONTE CARLO: " << op.ensayos << " ensayos, " << GeneradorSenal::getNombre(op.senal)
+         << ", " << op.tiempo << " s, ruido " << op.ruido << ", incertidumbre de la planta +-"
+         << op.incertidumbre * 100 << "%, semilla " << op.semilla << " ===" << endl;
+    cout << left << setw(18) << "medida" << right << setw(12) << "minimo" << setw(12) << "p50"
+         << setw(12) << "p90" << setw(12) << "p99" << setw(12) << "maximo" << setw(12) << "media"
+         << setw(12) << "no_finitos" << endl;
+    cout << setprecision(5);
+    for(int i = 0; i < MedidasEnsayo::CANTIDAD; i++) {
+        const EstadisticaCuantiles& e = estadisticas[i];
+        cout << left << setw(18) << nombresMedidasMonteCarlo[i] << right << setw(12) << e.getMinimo()
+             << setw(12) << e.cuantil(0.5) << setw(12) << e.cuantil(0.9) << setw(12) << e.cuantil(0.99)
+             << setw(12) << e.getMaximo() << setw(12) << e.media() << setw(12) << e.getNoFinitos() << endl;
+    }
+    if(invalidos > 0) cout << "Plantas invalidas (no se pudieron discretizar): " << invalidos << endl;
+    cout.flush();
+    cerr << op.ensayos << " ensayos en " << fixed << setprecision(3) << segundos << " s con "
+         << numHilos << " hilos" << endl;
+}
+
+// BENCHMARK DEL PASO
+// cuanto cuesta cada parte del lazo por muestra, para saber cuantos lazos entran en un
+// nucleo a 1-10 kHz: los nucleos aislados (generador, derivador con y sin pow, planta,
+// y los tres juntos) sobre una referencia precalculada, y el lazo completo de
+// SimuladorHIL con y sin archivo de resultados. cada medida es la mediana de varias
+// repeticiones; los ciclos son del contador TSC (solo x86).
+
+volatile double sumideroBench; // para que el compilador no descarte los calculos
+
+inline unsigned long long leerCiclos() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct MedicionBench {
+    string medida;
+    GeneradorSenal::TipoSenal senal;
+    long long pasos;
+    double nsPorPaso;
+    double ciclosPorPaso; // 0 = sin contador de ciclos
+};
+
+double mediana(vector<double> v) {
+    sort(v.begin(), v.end());
+    return v.empty() ? 0.0 : v[v.size() / 2];
+}
+
+// correr() hace 'pasos' pasos y devuelve algo que dependa de todos
+template <class Funcion>
+MedicionBench medirNucleo(const string& medida, GeneradorSenal::TipoSenal senal, long long pasos,
+                          int repeticiones, Funcion correr) {
+    vector<double> ns, ciclos;
+    for(int r = 0; r < repeticiones; r++) {
+        unsigned long long c0 = leerCiclos();
+        long long t0 = ahoraNs();
+        sumideroBench = sumideroBench + correr();
+        long long t1 = ahoraNs();
+        unsigned long long c1 = leerCiclos();
+        ns.push_back((double)(t1 - t0) / pasos);
+        ciclos.push_back((double)(c1 - c0) / pasos);
+    }
+    MedicionBench m;
+    m.medida = medida;
+    m.senal = senal;
+    m.pasos = pasos;
+    m.nsPorPaso = mediana(ns);
+    m.ciclosPorPaso = mediana(ciclos);
+    return m;
+}
+
+void imprimirMedicionBench(const MedicionBench& m) {
+    cout << left << setw(18) << m.medida << setw(10) << GeneradorSenal::getNombre(m.senal) << right
+         << fixed << setprecision(1) << setw(10) << m.nsPorPaso;
+    if(m.ciclosPorPaso > 0) cout << setw(12) << m.ciclosPorPaso;
+    else cout << setw(12) << "-";
+    // lazos de este costo que entran en un nucleo a 1 kHz y a 10 kHz
+    cout << setprecision(0) << setw(12) << floor(1e6 / m.nsPorPaso) << setw(12) << floor(1e5 / m.nsPorPaso)
+         << defaultfloat << endl;
+}
+
+void escribirBenchJSON(ostream& out, const vector<MedicionBench>& mediciones) {
+    streamsize precision = out.precision(6);
+    out << "{\"tau_s\": " << tau_s << ", \"mediciones\": [";
+    for(size_t i = 0; i < mediciones.size(); i++) {
+        const MedicionBench& m = mediciones[i];
+        out << (i ? ",\n  " : "\n  ") << "{\"medida\": \"" << m.medida << "\", \"senal\": \""
+            << GeneradorSenal::getNombre(m.senal) << "\", \"pasos\": " << m.pasos
+            << ", \"ns_por_paso\": " << m.nsPorPaso << ", \"ciclos_por_paso\": ";
+        if(m.ciclosPorPaso > 0) out << m.ciclosPorPaso;
+        else out << "null";
+        out << "}";
+    }
+    out << "\n]}" << endl;
+    out.precision(precision);
+}
+
+void benchmarkPaso(long long pasos, double tiempo, const PlantaSISO& planta, const string& archivoJSON) {
+    const int REPETICIONES = 7, REPETICIONES_LAZO = 5;
+    vector<MedicionBench> mediciones;
+    
+    cout << "=== BENCHMARK DEL PASO HIL ===" << endl;
+    cout << "nucleos: " << pasos << " pasos por medida; lazo completo: " << tiempo << " s simulados ("
+         << (long long)(tiempo / tau_s) << " muestras); mediana de " << REPETICIONES << " / "
+         << REPETICIONES_LAZO << " repeticiones" << endl;
+    cout << "lazos@f = cuantos lazos de ese costo entran en un nucleo a esa frecuencia" << endl;
+    cout << left << setw(18) << "medida" << setw(10) << "senal" << right << setw(10) << "ns/paso"
+         << setw(12) << "ciclos/paso" << setw(12) << "lazos@1kHz" << setw(12) << "lazos@10kHz" << endl;
+    
+    for(int senal = 1; senal <= 3; senal++) {
+        GeneradorSenal::TipoSenal tipo = static_cast<GeneradorSenal::TipoSenal>(senal);
+        vector<double> refs(pasos);
+        for(long long k = 0; k < pasos; k++) refs[k] = GeneradorSenal::generar(tipo, k * tau_s);
+        
+        mediciones.push_back(medirNucleo("generador", tipo, pasos, REPETICIONES, [&]() {
+            double suma = 0.0;
+            for(long long k = 0; k < pasos; k++) suma += GeneradorSenal::generar(tipo, k * tau_s);
+            return suma;
+        }));
+        mediciones.push_back(medirNucleo("derivador_pow", tipo, pasos, REPETICIONES, [&]() {
+            DerivadorReferencia d;
+            double suma = 0.0;
+            for(long long k = 0; k < pasos; k++) { d.actualizar(refs[k]); suma += d.z0; }
+            return suma;
+        }));
+        mediciones.push_back(medirNucleo("derivador", tipo, pasos, REPETICIONES, [&]() {
+            Derivador d;
+            double suma = 0.0;
+            for(long long k = 0; k < pasos; k++) { d.actualizar(refs[k]); suma += d.z[0]; }
+            return suma;
+        }));
+        mediciones.push_back(medirNucleo("planta", tipo, pasos, REPETICIONES, [&]() {
+            PlantaSISO p(planta);
+            p.reset();
+            double suma = 0.0;
+            for(long long k = 0; k < pasos; k++) suma += p.actualizar(refs[k]);
+            return suma;
+        }));
+        mediciones.push_back(medirNucleo("paso", tipo, pasos, REPETICIONES, [&]() {
+            Derivador d;
+            PlantaSISO p(planta);
+            p.reset();
+            double suma = 0.0;
+            for(long long k = 0; k < pasos; k++) {
+                d.actualizar(GeneradorSenal::generar(tipo, k * tau_s));
+                suma += p.actualizar(d.z[0]);
+            }
+            return suma;
+        }));
+        
+        // lazo completo de SimuladorHIL (hilo registrador incluido), con y sin archivo
+        for(int conTraza = 1; conTraza >= 0; conTraza--) {
+            OpcionesTraza traza;
+            traza.guardar = (conTraza == 1);
+            long long muestras = (long long)(tiempo / tau_s);
+            mediciones.push_back(medirNucleo(conTraza ? "lazo_con_traza" : "lazo_sin_traza", tipo, muestras,
+                                             REPETICIONES_LAZO, [&]() {
+                SimuladorHIL<3> simulador(traza, OpcionesTiempoReal(), planta);
+                simulador.configurar(tipo, tiempo, "bench_traza.tmp");
+                simulador.ejecutar();
+                return simulador.getResumen().rmsSeguimiento();
+            }));
+        }
+        remove("bench_traza.tmp");
+        
+        for(size_t i = mediciones.size() - 7; i < mediciones.size(); i++) imprimirMedicionBench(mediciones[i]);
+    }
+    
+    if(archivoJSON == "-") {
+        escribirBenchJSON(cout, mediciones);
+    } else if(!archivoJSON.empty()) {
+        ofstream json(archivoJSON.c_str());
+        escribirBenchJSON(json, mediciones);
+    }
+}
+
+// PLANTA EN OTRO PROCESO (solo Linux)
+// co-simulacion con la planta en un proceso aparte, como el "hardware" de un banco HIL
+// de verdad: el lazo de control y la planta solo se comunican por dos anillos en memoria
+// compartida (u hacia la planta, y de vuelta). cada muestra es un viaje de ida y vuelta
+// y se mide su latencia. el que espera puede girar sobre el contador (spin, cede el
+// nucleo cada tanto para que funcione con un solo nucleo) o dormir en un futex sobre el
+// mismo contador, que el otro lado despierta solo si hay alguien esperando.
+
+#ifdef __linux__
+
+struct MensajeHIL {
+    long long k;   // numero de muestra; -1 = terminar
+    double valor;  // u hacia la planta, y de vuelta
+};
+
+// anillo SPSC de tamaño fijo para vivir en memoria compartida (sin punteros ni vector);
+// los contadores de 32 bits sirven a la vez de palabra del futex
+struct AnilloCompartido {
+    static const uint32_t CAPACIDAD = 64;
+    
+    alignas(64) atomic<uint32_t> escritura;
+    atomic<uint32_t> esperando;   // el consumidor esta (o va a estar) dormido en el futex
+    alignas(64) atomic<uint32_t> lectura;
+    alignas(64) MensajeHIL mensajes[CAPACIDAD];
+    
+    AnilloCompartido() : escritura(0), esperando(0), lectura(0) {}
+};
+
+struct MemoriaCompartidaHIL {
+    AnilloCompartido haciaPlanta, desdePlanta;
+    char avisosPlanta[256]; // el proceso de la planta no escribe en pantalla
+};
+
+static_assert(sizeof(atomic<uint32_t>) == sizeof(int), "el futex necesita una palabra de 32 bits");
+
+inline long futex(atomic<uint32_t>* palabra, int operacion, uint32_t valor, const timespec* espera) {
+    return syscall(SYS_futex, reinterpret_cast<int*>(palabra), operacion, valor, espera, NULL, 0);
+}
+
+inline void pausaEspera(unsigned& vueltas) {
+    if(++vueltas % 1024 == 0) sched_yield();
+#if defined(__x86_64__) || defined(__i386__)
+    else _mm_pause();
+#endif
+}
+
+class CanalCompartido {
+private:
+    AnilloCompartido& anillo;
+    bool girar;     // spin en vez de futex
+    pid_t companero; // > 0: proceso a vigilar mientras se espera (el hijo o el padre)
+    
+    // el padre esta vivo mientras siga siendo el padre (si muere, al hijo lo adopta otro);
+    // el hijo, mientras waitpid no lo encuentre terminado
+    bool companeroVivo() const {
+        return companero <= 0 || getppid() == companero || waitpid(companero, NULL, WNOHANG) == 0;
+    }
+    
+public:
+    CanalCompartido(AnilloCompartido& a, bool spin, pid_t otro) : anillo(a), girar(spin), companero(otro) {}
+    
+    // productor; espera (girando) si el anillo esta lleno
+    void enviar(const MensajeHIL& m) {
+        uint32_t e = anillo.escritura.load(memory_order_relaxed);
+        unsigned vueltas = 0;
+        while(e - anillo.lectura.load(memory_order_acquire) == AnilloCompartido::CAPACIDAD) pausaEspera(vueltas);
+        anillo.mensajes[e % AnilloCompartido::CAPACIDAD] = m;
+        anillo.escritura.store(e + 1, memory_order_seq_cst);
+        // seq_cst de los dos lados: o el consumidor ve el mensaje nuevo, o aca se ve que duerme
+        if(!girar && anillo.esperando.load(memory_order_seq_cst)) futex(&anillo.escritura, FUTEX_WAKE, 1, NULL);
+    }
+    
+    // consumidor; false si el otro proceso termino sin contestar
+    bool recibir(MensajeHIL& m) {
+        uint32_t l = anillo.lectura.load(memory_order_relaxed);
+        unsigned vueltas = 0;
+        while(anillo.escritura.load(memory_order_acquire) == l) {
+            if(girar) {
+                pausaEspera(vueltas);
+                if(vueltas % (1 << 20) == 0 && !companeroVivo()) return false;
+                continue;
+            }
+            anillo.esperando.store(1, memory_order_seq_cst);
+            if(anillo.escritura.load(memory_order_seq_cst) == l) {
+                // duerme solo si el contador sigue en l; despierta cada 100 ms para vigilar
+                timespec espera = {0, 100000000};
+                if(futex(&anillo.escritura, FUTEX_WAIT, l, &espera) != 0 && errno == ETIMEDOUT && !companeroVivo()) {
+                    anillo.esperando.store(0, memory_order_relaxed);
+                    return false;
+                }
+            }
+            anillo.esperando.store(0, memory_order_relaxed);
+        }
+        m = anillo.mensajes[l % AnilloCompartido::CAPACIDAD];
+        anillo.lectura.store(l + 1, memory_order_release);
+        return true;
+    }
+};
+
+// SCHED_FIFO, afinidad y memoria bloqueada de uno de los dos procesos. mlockall no se
+// hereda con fork, asi que cada proceso bloquea la suya
+string configurarProcesoTiempoReal(const OpcionesTiempoReal& opciones) {
+    string avisos;
+    if(opciones.bloquearMemoria && mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        avisos += "no se pudo bloquear la memoria (mlockall); ";
+    return avisos + configurarHiloTiempoReal(opciones);
+}
+
+// el proceso de la planta: contesta cada u con y hasta recibir k = -1
+void servirPlanta(MemoriaCompartidaHIL* memoria, bool spin, const PlantaSISO& nominal,
+                  const OpcionesTiempoReal& tiempoReal, pid_t padre) {
+    prctl(PR_SET_PDEATHSIG, SIGKILL); // si el lazo de control muere, la planta tambien
+    if(getppid() != padre) _exit(0);  // ... salvo que haya muerto antes del prctl
+    if(tiempoReal.activo) {
+        string avisos = configurarProcesoTiempoReal(tiempoReal);
+        strncpy(memoria->avisosPlanta, avisos.c_str(), sizeof(memoria->avisosPlanta) - 1);
+    }
+    CanalCompartido entrada(memoria->haciaPlanta, spin, padre), salida(memoria->desdePlanta, spin, padre);
+    PlantaSISO planta(nominal);
+    planta.reset();
+    MensajeHIL m;
+    while(entrada.recibir(m) && m.k >= 0) {
+        m.valor = planta.actualizar(m.valor);
+        salida.enviar(m);
+    }
+}
+
+#endif
+
+// percentil por rango mas cercano de un vector ordenado
+double percentilOrdenado(const vector<double>& ordenados, double q) {
+    if(ordenados.empty()) return 0.0;
+    size_t rango = (size_t)ceil(q * ordenados.size());
+    return ordenados[min(ordenados.size(), max<size_t>(rango, 1)) - 1];
+}
+
+bool ejecutarPlantaProceso(GeneradorSenal::TipoSenal tipo, double tiempo, const PlantaSISO& planta, bool spin,
+                           const OpcionesTiempoReal& tiempoReal) {
+#ifdef __linux__
+    long long muestras = (long long)(tiempo / tau_s);
+    if(muestras <= 0) {
+        cerr << "Error: --tiempo tiene que alcanzar para al menos una muestra (" << tau_s << " s)" << endl;
+        return false;
+    }
+    void* region = mmap(NULL, sizeof(MemoriaCompartidaHIL), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(region == MAP_FAILED) {
+        cerr << "Error: no se pudo crear la memoria compartida" << endl;
+        return false;
+    }
+    MemoriaCompartidaHIL* memoria = new (region) MemoriaCompartidaHIL();
+    memset(memoria->avisosPlanta, 0, sizeof(memoria->avisosPlanta));
+    
+    // la planta va en otro nucleo: el pedido, o el siguiente al del lazo de control
+    OpcionesTiempoReal opcionesPlanta = tiempoReal;
+    if(tiempoReal.cpuPlanta >= 0) opcionesPlanta.cpu = tiempoReal.cpuPlanta;
+    else if(tiempoReal.cpu >= 0) opcionesPlanta.cpu = (tiempoReal.cpu + 1) % max(1u, thread::hardware_concurrency());
+    
+    cout.flush(); // que el hijo no herede salida pendiente
+    pid_t padre = getpid();
+    pid_t pid = fork();
+    if(pid < 0) {
+        cerr << "Error: no se pudo crear el proceso de la planta" << endl;
+        munmap(region, sizeof(MemoriaCompartidaHIL));
+        return false;
+    }
+    if(pid == 0) {
+        servirPlanta(memoria, spin, planta, opcionesPlanta, padre);
+        _exit(0);
+    }
+    
+    string avisos = tiempoReal.activo ? configurarProcesoTiempoReal(tiempoReal) : "";
+    CanalCompartido haciaPlanta(memoria->haciaPlanta, spin, pid), desdePlanta(memoria->desdePlanta, spin, pid);
+    Derivador derivador;
+    PlantaSISO local(planta); // la misma planta en este proceso, para comprobar el resultado
+    local.reset();
+    vector<double> latencias;
+    latencias.reserve(muestras);
+    double difMax = 0.0;
+    bool ok = true;
+    long long periodo = (long long)llround(tau_s * 1e9), plazo = ahoraNs();
+    
+    for(long long k = 0; k < muestras; k++) {
+        derivador.actualizar(GeneradorSenal::generar(tipo, k * tau_s));
+        MensajeHIL m = {k, derivador.z[0]};
+        long long t0 = ahoraNs();
+        haciaPlanta.enviar(m);
+        if(!desdePlanta.recibir(m) || m.k != k) {
+            cerr << "Error: el proceso de la planta no contesto la muestra " << k << endl;
+            ok = false;
+            break;
+        }
+        latencias.push_back((ahoraNs() - t0) / 1000.0);
+        difMax = max(difMax, fabs(m.valor - local.actualizar(derivador.z[0])));
+        if(tiempoReal.activo) {
+            plazo += periodo;
+            int error = dormirHasta(plazo);
+            if(error != 0) {
+                cerr << "Error: clock_nanosleep fallo (" << strerror(error) << ") en la muestra " << k << endl;
+                ok = false;
+                break;
+            }
+        }
+    }
+    MensajeHIL fin = {-1, 0.0};
+    if(ok) haciaPlanta.enviar(fin);
+    else kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    string avisosPlanta(memoria->avisosPlanta);
+    munmap(region, sizeof(MemoriaCompartidaHIL));
+    if(!ok) return false;
+    
+    if(!avisos.empty()) cout << "Aviso (lazo de control): " << avisos << endl;
+    if(!avisosPlanta.empty()) cout << "Aviso (proceso de la planta): " << avisosPlanta << endl;
+    sort(latencias.begin(), latencias.end());
+    double suma = 0.0;
+    for(size_t i = 0; i < latencias.size(); i++) suma += latencias[i];
+    
+    cout << "=== PLANTA EN OTRO PROCESO (" << (spin ? "spin" : "futex") << ", " << GeneradorSenal::getNombre(tipo)
+         << ", " << muestras << " muestras" << (tiempoReal.activo ? ", a tiempo real" : "") << ") ===" << endl;
+    cout << "Ida y vuelta u -> planta -> y (us):" << endl;
+    cout << fixed << setprecision(2);
+    cout << "  minimo " << latencias.front() << "  p50 " << percentilOrdenado(latencias, 0.5)
+         << "  p90 " << percentilOrdenado(latencias, 0.9) << "  p99 " << percentilOrdenado(latencias, 0.99)
+         << "  p99.9 " << percentilOrdenado(latencias, 0.999) << "  maximo " << latencias.back() << endl;
+    cout << "  media " << suma / latencias.size() << " us = " << setprecision(3)
+         << 100.0 * (suma / latencias.size()) / (tau_s * 1e6) << "% del periodo de " << setprecision(0)
+         << tau_s * 1e6 << " us" << endl;
+    cout << defaultfloat;
+    if(difMax == 0.0) cout << "La salida de la planta coincide exactamente con la simulacion en un solo proceso." << endl;
+    else cout << "La salida de la planta difiere de la simulacion en un solo proceso (maximo " << difMax << ")" << endl;
+    return difMax == 0.0;
+#else
+    (void)tipo; (void)tiempo; (void)planta; (void)spin; (void)tiempoReal;
+    cerr << "La planta en otro proceso solo esta disponible en Linux" << endl;
+    return false;
+#endif
+}
+
+// flujo interactivo de siempre, con el derivador del orden elegido
+template <int N>
+void ejecutarInteractivo(const OpcionesTraza& traza, const OpcionesTiempoReal& tiempoReal, const PlantaSISO& planta,
+                         const string& archivoJSON) {
+    SimuladorHIL<N> simulador(traza, tiempoReal, planta);
+    simulador.setJSON(archivoJSON);
     
     // Configurar parametros
     simulador.configurar();
@@ -350,6 +2684,143 @@ int main() {
     
     // Ofrecer generar script de graficacion
     simulador.generarScriptPython();
+}
+
+
+int main(int argc, char* argv[]) {
+    // opciones de linea de comandos (sin opciones: modo interactivo de siempre)
+    string archivoBarrido;
+    GeneradorSenal::TipoSenal tipo = GeneradorSenal::ESCALON;
+    double tiempo = 40.0;
+    int orden = 3;
+    OpcionesTraza traza;
+    OpcionesTiempoReal tiempoReal;
+    vector<double> numerador(numeradorPlanta, numeradorPlanta + 3);
+    vector<double> denominador(denominadorPlanta, denominadorPlanta + 4);
+    double prewarp = 0.0;
+    bool pedirVerificarPlanta = false;
+    bool pedirVerificarDerivador = false;
+    string archivoEscenarios;
+    int numHilos = 0;
+    OpcionesMonteCarlo montecarlo;
+    bool pedirMonteCarlo = false;
+    string archivoJSON;
+    long long pasosBench = 0;
+    bool pedirComparacion = false;
+    bool barridoSimple = false;
+    bool pedirPlantaProceso = false;
+    bool esperaGirando = false;
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if(arg == "--orden" && i + 1 < argc) orden = atoi(argv[++i]);
+        else if(arg == "--frecuencia" && i + 1 < argc) {
+            double hz = atof(argv[++i]);
+            if(hz > 0) tau_s = 1.0 / hz;
+        }
+        else if(arg == "--num" && i + 1 < argc) numerador = leerPolinomio(argv[++i]);
+        else if(arg == "--den" && i + 1 < argc) denominador = leerPolinomio(argv[++i]);
+        else if(arg == "--prewarp" && i + 1 < argc) prewarp = atof(argv[++i]);
+        else if(arg == "--verificar-planta") pedirVerificarPlanta = true;
+        else if(arg == "--escenarios" && i + 1 < argc) archivoEscenarios = argv[++i];
+        else if(arg == "--hilos" && i + 1 < argc) numHilos = atoi(argv[++i]);
+        else if(arg == "--montecarlo") {
+            pedirMonteCarlo = true;
+            if(i + 1 < argc && isdigit(argv[i + 1][0])) montecarlo.ensayos = atoll(argv[++i]);
+        }
+        else if(arg == "--bench") {
+            pasosBench = 1000000;
+            if(i + 1 < argc && isdigit(argv[i + 1][0])) pasosBench = atoll(argv[++i]);
+        }
+        else if(arg == "--planta-proceso") {
+            pedirPlantaProceso = true;
+            if(i + 1 < argc && (string(argv[i + 1]) == "spin" || string(argv[i + 1]) == "futex")) {
+                esperaGirando = (string(argv[++i]) == "spin");
+            }
+        }
+        else if(arg == "--comparar-precision") pedirComparacion = true;
+        else if(arg == "--precision" && i + 1 < argc) barridoSimple = (string(argv[++i]) == "float");
+        else if(arg == "--semilla" && i + 1 < argc) montecarlo.semilla = strtoull(argv[++i], NULL, 10);
+        else if(arg == "--ruido" && i + 1 < argc) montecarlo.ruido = atof(argv[++i]);
+        else if(arg == "--incertidumbre" && i + 1 < argc) montecarlo.incertidumbre = atof(argv[++i]);
+        else if(arg == "--tiempo-real") tiempoReal.activo = true;
+        else if(arg == "--fifo") {
+            tiempoReal.activo = true;
+            tiempoReal.prioridad = (i + 1 < argc && isdigit(argv[i + 1][0])) ? atoi(argv[++i]) : 80;
+        }
+        else if(arg == "--cpu" && i + 1 < argc) { tiempoReal.activo = true; tiempoReal.cpu = atoi(argv[++i]); }
+        else if(arg == "--mlock") tiempoReal.activo = tiempoReal.bloquearMemoria = true;
+        else if(arg == "--cpu-planta" && i + 1 < argc) {
+            tiempoReal.activo = true;
+            tiempoReal.cpuPlanta = atoi(argv[++i]);
+        }
+        else if(arg == "--binario") traza.binario = true;
+        else if(arg == "--sin-traza") traza.guardar = false;
+        else if(arg == "--json" && i + 1 < argc) archivoJSON = argv[++i];
+        else if(arg == "--float32") traza.binario = traza.float32 = true;
+        else if(arg == "--anillo" && i + 1 < argc) traza.capacidadAnillo = atoi(argv[++i]);
+        else if(arg == "--decimar" && i + 1 < argc) traza.decimacion = atoi(argv[++i]);
+        else if(arg == "--convertir" && i + 1 < argc) {
+            string entrada = argv[++i];
+            string salida = (i + 1 < argc) ? argv[++i] : "";
+            if(salida.empty()) {
+                size_t punto = entrada.rfind('.');
+                salida = (punto == string::npos ? entrada : entrada.substr(0, punto)) + ".txt";
+            }
+            return convertirTraza(entrada, salida) ? 0 : 1;
+        }
+        else if(arg == "--verificar-derivador") pedirVerificarDerivador = true;
+        else if(arg == "--barrido" && i + 1 < argc) archivoBarrido = argv[++i];
+        else if(arg == "--senal" && i + 1 < argc) {
+            int opcion = atoi(argv[++i]);
+            if(opcion >= 1 && opcion <= 3) tipo = static_cast<GeneradorSenal::TipoSenal>(opcion);
+        }
+        else if(arg == "--tiempo" && i + 1 < argc) tiempo = atof(argv[++i]);
+        else if(arg == "--generar-configs") {
+            int cantidad = (i + 1 < argc) ? atoi(argv[i + 1]) : 10000;
+            unsigned semilla = (i + 2 < argc) ? (unsigned)atoi(argv[i + 2]) : 12345;
+            generarConfiguraciones(cantidad, semilla);
+            return 0;
+        }
+    }
+    
+    if(pedirVerificarDerivador) return verificarDerivador(tiempo) ? 0 : 1;
+    
+    PlantaSISO planta;
+    if(!planta.definir(numerador, denominador, tau_s, prewarp)) {
+        cerr << "Error: la planta debe ser propia (grado del numerador <= grado del denominador)" << endl;
+        return 1;
+    }
+    if(pedirVerificarPlanta) return verificarPlanta(planta) ? 0 : 1;
+    if(pedirPlantaProceso) return ejecutarPlantaProceso(tipo, tiempo, planta, esperaGirando, tiempoReal) ? 0 : 1;
+    if(pedirComparacion) {
+        compararPrecision(tiempo, planta);
+        return 0;
+    }
+    if(pasosBench > 0) {
+        benchmarkPaso(pasosBench, tiempo, planta, archivoJSON);
+        return 0;
+    }
+    if(pedirMonteCarlo) {
+        montecarlo.senal = tipo;
+        montecarlo.tiempo = tiempo;
+        montecarlo.hilos = numHilos;
+        ejecutarMonteCarlo(montecarlo, planta);
+        return 0;
+    }
+    if(!archivoEscenarios.empty()) return ejecutarEscenarios(archivoEscenarios, numHilos, traza, planta, archivoJSON) ? 0 : 1;
+    
+    if(!archivoBarrido.empty()) {
+        ejecutarBarrido(archivoBarrido, tipo, tiempo, planta, barridoSimple);
+        return 0;
+    }
+    
+    switch(orden) {
+        case 1: ejecutarInteractivo<1>(traza, tiempoReal, planta, archivoJSON); break;
+        case 2: ejecutarInteractivo<2>(traza, tiempoReal, planta, archivoJSON); break;
+        case 4: ejecutarInteractivo<4>(traza, tiempoReal, planta, archivoJSON); break;
+        case 5: ejecutarInteractivo<5>(traza, tiempoReal, planta, archivoJSON); break;
+        default: ejecutarInteractivo<3>(traza, tiempoReal, planta, archivoJSON); break;
+    }
     
     cout << "\n¡Gracias por usar el simulador HIL!" << endl;
     